@@ -0,0 +1,83 @@
+#ifndef ANDERSENAA_H_
+#define ANDERSENAA_H_
+#include "LLVMEssentials.hh"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/SparseBitVector.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include <vector>
+
+namespace pdg
+{
+  // flow, context and field insensitive inclusion based (Andersen style) points-to analysis
+  // over a whole module. Abstract objects are allocas, globals and functions. Every object is
+  // a single node, so a pointer into an object and the object's contents share the same
+  // points-to set. Memory the module cannot see is a single unknown object: pointers made from
+  // integers, aggregates or va_arg point to it, and objects handed to external code escape
+  // into it, so what external calls return and external callers pass in points to every
+  // escaped object plus the unknown object.
+  class AndersenAA
+  {
+  public:
+    AndersenAA() = default;
+    AndersenAA(const AndersenAA &) = delete;
+    AndersenAA &operator=(const AndersenAA &) = delete;
+    void analyze(llvm::Module &M);
+    void clear();
+    // NoAlias when both points-to sets are known, free of the unknown object and disjoint,
+    // MayAlias otherwise
+    llvm::AliasResult alias(const llvm::Value *v1, const llvm::Value *v2) const;
+    // nullptr when nothing is known about v
+    const llvm::SparseBitVector<> *getPointsToSet(const llvm::Value *v) const;
+
+  private:
+    static constexpr unsigned NO_NODE = ~0u;
+    unsigned createNode();
+    unsigned getOrCreateValueNode(const llvm::Value *v);
+    unsigned getOrCreateObjectNode(const llvm::Value *alloc_site);
+    unsigned getOrCreateRetNode(const llvm::Function *f);
+    // node of a pointer operand, looking through constant casts and geps
+    unsigned getPointerNode(const llvm::Value *v);
+    unsigned lookupPointerNode(const llvm::Value *v) const;
+    void push(unsigned n);
+    void addAddressOf(unsigned dst, unsigned obj);
+    bool addCopy(unsigned src, unsigned dst);
+    void addLoad(unsigned dst, unsigned src_ptr);
+    void addStore(unsigned dst_ptr, unsigned src);
+    void addGlobalInitializer(unsigned obj, const llvm::Constant *init);
+    // the objects n points to become reachable from external code
+    void addEscape(unsigned n);
+    void escapeObject(unsigned obj);
+    void addInstructionConstraints(llvm::Instruction &inst);
+    void addCallConstraints(llvm::CallBase &cb);
+    void bindCall(llvm::CallBase &cb, const llvm::Function &callee);
+    void bindExternalCall(llvm::CallBase &cb);
+    void solve();
+
+    std::vector<llvm::SparseBitVector<>> _pts;
+    std::vector<llvm::SmallVector<unsigned, 2>> _copy_succs;
+    llvm::DenseSet<std::pair<unsigned, unsigned>> _copy_edges;
+    // n -> nodes that load through n / nodes stored through n
+    std::vector<llvm::SmallVector<unsigned, 1>> _loads;
+    std::vector<llvm::SmallVector<unsigned, 1>> _stores;
+    // n -> indirect calls whose called operand is n
+    std::vector<llvm::SmallVector<llvm::CallBase *, 1>> _ind_calls;
+    llvm::DenseSet<std::pair<llvm::CallBase *, const llvm::Function *>> _bound_calls;
+    llvm::DenseMap<const llvm::Value *, unsigned> _value_nodes;
+    llvm::DenseMap<const llvm::Value *, unsigned> _object_nodes;
+    llvm::DenseMap<const llvm::Function *, unsigned> _ret_nodes;
+    // object node -> allocation site, nullptr for value nodes
+    std::vector<const llvm::Value *> _object_sites;
+    // points to itself and to every escaped object
+    unsigned _unknown = NO_NODE;
+    llvm::SparseBitVector<> _escaped;
+    // only set while analyze runs
+    const llvm::TargetLibraryInfo *_tli = nullptr;
+    std::vector<unsigned> _worklist;
+    std::vector<bool> _queued;
+    bool _solving = false;
+  };
+} // namespace pdg
+
+#endif
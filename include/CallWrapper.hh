@@ -13,8 +13,9 @@ namespace pdg
       llvm::CallInst* _call_inst;
       llvm::Function* _called_func;
       std::vector<llvm::Value *> _arg_list;
-      std::map<llvm::Value *, Tree *> _arg_actual_in_tree_map;
-      std::map<llvm::Value *, Tree *> _arg_actual_out_tree_map;
+      // in argument order
+      llvm::MapVector<llvm::Value *, Tree *> _arg_actual_in_tree_map;
+      llvm::MapVector<llvm::Value *, Tree *> _arg_actual_out_tree_map;
       Tree * _ret_val_actual_in_tree;
       Tree * _ret_val_actual_out_tree;
 
@@ -23,6 +24,8 @@ namespace pdg
       {
         _call_inst = &ci;
         _called_func = pdgutils::getCalledFunc(ci);
+        _ret_val_actual_in_tree = nullptr;
+        _ret_val_actual_out_tree = nullptr;
         for (auto arg_iter = ci.arg_begin(); arg_iter != ci.arg_end(); arg_iter++)
         {
           _arg_list.push_back(*arg_iter);
@@ -38,6 +41,7 @@ namespace pdg
       Tree *getRetActualInTree() { return _ret_val_actual_in_tree; }
       Tree *getRetActualOutTree() { return _ret_val_actual_out_tree; }
       bool hasNullRetVal() { return (_ret_val_actual_in_tree == nullptr); }
+      size_t getMemoryUsage() const;
   };
 }
 
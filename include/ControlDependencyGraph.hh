@@ -1,6 +1,10 @@
 #ifndef CONTROLDEPENDENCYGRAPH_H_
 #define CONTROLDEPENDENCYGRAPH_H_
 #include "Graph.hh"
+#include "ProgramGraphWrapperPass.hh"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Analysis/PostDominators.h"
 
 
@@ -10,17 +14,31 @@ namespace pdg
   class ControlDependencyGraph : public llvm::FunctionPass
   {
   public:
+    typedef llvm::DenseMap<llvm::BasicBlock *, llvm::SmallVector<llvm::BasicBlock *, 4>> BlockListMap;
     static char ID;
     ControlDependencyGraph() : llvm::FunctionPass(ID){};
     void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
     llvm::StringRef getPassName() const override { return "Control Dependency Graph"; }
     bool runOnFunction(llvm::Function &F) override;
+    // add the control dependency edges of F to g. The pdg pass calls this directly, a function
+    // pass that is run on the fly from a module pass cannot see the module level graph holder
+    void computeControlDependencies(llvm::Function &F, ProgramGraph &g, llvm::PostDominatorTree &PDT);
     void addControlDepFromNodeToBB(Node &n, llvm::BasicBlock &bb, EdgeType edge_type);
     void addControlDepFromEntryNodeToInsts(llvm::Function &F);
-    void addControlDepFromDominatedBlockToDominator(llvm::Function &F);
+    // post dominance frontier of every block of F, computed bottom up over the post dominator tree
+    void computePostDomFrontiers(llvm::Function &F, BlockListMap &pdf);
+    void addControlDepFromPostDomFrontiers(llvm::Function &F);
   private:
+    ProgramGraph *_PDG;
     llvm::PostDominatorTree *_PDT;
   };
+
+  // -passes=cdg, a module pass so it can reach the module level graph
+  class ControlDependencyGraphPass : public llvm::PassInfoMixin<ControlDependencyGraphPass>
+  {
+  public:
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &MAM);
+  };
 } // namespace pdg
 
 #endif
\ No newline at end of file
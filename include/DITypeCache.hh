@@ -0,0 +1,52 @@
+#ifndef DITYPECACHE_H_
+#define DITYPECACHE_H_
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pdg
+{
+  // debug info type walks memoized per DIType, so that expanding, binding and naming the same
+  // struct type again is a lookup. Shared by TreeShape, ProgramGraph::computeNodeDIType and
+  // pdgutils::computeTreeNodeID through the graph arena. Results are valid as long as the
+  // module's metadata is
+  class DITypeCache
+  {
+  public:
+    DITypeCache() = default;
+    DITypeCache(const DITypeCache &) = delete;
+    DITypeCache &operator=(const DITypeCache &) = delete;
+    // dbgutils::stripAttributes, nullptr for a null type or a qualifier without base type
+    llvm::DIType *getStrippedType(llvm::DIType *dt);
+    // the type a value of type dt is, with qualifiers, typedefs and the member tag stripped.
+    // Two tree nodes describe the same object type iff their canonical types are equal
+    llvm::DIType *getCanonicalType(llvm::DIType *dt);
+    // dbgutils::getLowestDIType
+    llvm::DIType *getLowestType(llvm::DIType *dt);
+    // the members of a struct type as DITypes (nullptr for members that are not types), empty
+    // for every other type
+    const std::vector<llvm::DIType *> &getFields(llvm::DIType *dt);
+    // the types of the children a tree node of type dt gets: the pointee of a pointer, the
+    // members of a struct, after stripping qualifiers, typedefs and the member tag
+    const std::vector<llvm::DIType *> &getChildTypes(llvm::DIType *dt);
+    // dbgutils::getSourceLevelTypeName / getSourceLevelVariableName
+    const std::string &getTypeName(llvm::DIType *dt);
+    const std::string &getVariableName(llvm::DIType *dt);
+    size_t size() const { return _child_types.size() + _fields.size(); }
+    size_t getMemoryUsage() const;
+    void clear();
+
+  private:
+    llvm::DenseMap<llvm::DIType *, llvm::DIType *> _stripped_types;
+    llvm::DenseMap<llvm::DIType *, llvm::DIType *> _lowest_types;
+    // node based maps, callers hold on to the returned references
+    std::unordered_map<llvm::DIType *, std::vector<llvm::DIType *>> _fields;
+    std::unordered_map<llvm::DIType *, std::vector<llvm::DIType *>> _child_types;
+    std::unordered_map<llvm::DIType *, std::string> _type_names;
+    std::unordered_map<llvm::DIType *, std::string> _variable_names;
+  };
+} // namespace pdg
+
+#endif
@@ -1,28 +1,108 @@
 #ifndef DATADEPENDENCYGRAPH_H_
 #define DATADEPENDENCYGRAPH_H_
 #include "Graph.hh"
+#include "ProgramGraphWrapperPass.hh"
+#include "AndersenAA.hh"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
 #include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/BasicAliasAnalysis.h"
+#include "llvm/Analysis/PhiValues.h"
+#include "llvm/Analysis/ScopedNoAliasAA.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/TypeBasedAliasAnalysis.h"
+#include <functional>
 
 namespace pdg
 {
-  class DataDependencyGraph : public llvm::ModulePass
+  // collects the data edges of one function without touching the graph, so that several
+  // functions can be processed at once. Edges are kept in the order the builders emit them
+  // and are added to the graph by DataDependencyGraph.
+  class DataEdgeCollector
   {
   public:
-    static char ID;
-    DataDependencyGraph() : llvm::ModulePass(ID) {};
-    void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
-    llvm::StringRef getPassName() const override { return "Data Dependency Graph"; }
-    bool runOnModule(llvm::Module &M) override;
+    struct PendingEdge
+    {
+      Node *src;
+      Node *dst;
+      EdgeType edge_type;
+    };
+    // RAW edges come from mem_dep_res or, with -pdg-raw=memssa, from mssa; the other one may
+    // be null. aa backs -pdg-alias=basicaa|tbaa and the memssa kill checks, andersen backs
+    // -pdg-alias=anders.
+    DataEdgeCollector(ProgramGraph &g, llvm::MemoryDependenceResults *mem_dep_res, llvm::MemorySSA *mssa, llvm::AAResults *aa, const AndersenAA *andersen);
+    // all data edges of F, in instruction order
+    void collect(llvm::Function &F);
+    std::vector<PendingEdge> &getEdges() { return _edges; }
     void addDefUseEdges(llvm::Instruction &inst);
     void addRAWEdges(llvm::Instruction &inst);
+    // every store reaching the load through memory phis, a store that overwrites the whole
+    // loaded location ends its path
+    void addMemorySSARAWEdges(llvm::LoadInst &li);
     void addAliasEdges(llvm::Instruction &inst);
     void addCalleeEdge(llvm::CallInst &inst);
     llvm::AliasResult queryAliasUnderApproximate(llvm::Value &v1, llvm::Value &v2);
+    // query the backend selected by -pdg-alias, cached per function
+    llvm::AliasResult queryAlias(llvm::Value &v1, llvm::Value &v2);
 
   private:
+    void buildAliasIndex(llvm::Function &F);
+    llvm::MemoryLocation getAliasLocation(llvm::Value &v);
+    void addEdge(Node *src, Node *dst, EdgeType edge_type) { _edges.push_back({src, dst, edge_type}); }
+
+    ProgramGraph &_g;
     llvm::MemoryDependenceResults *_mem_dep_res;
+    llvm::MemorySSA *_mssa;
+    llvm::Optional<llvm::BatchAAResults> _batch_aa;
+    const AndersenAA *_andersen;
+    // pointer operand -> pointer values stored through it, in function order
+    llvm::DenseMap<llvm::Value *, llvm::SmallVector<llvm::Instruction *, 2>> _stored_values;
+    llvm::DenseMap<llvm::Instruction *, unsigned> _inst_order;
+    // pointer typed instructions of the function, in function order
+    std::vector<llvm::Instruction *> _ptr_insts;
+    llvm::DenseMap<std::pair<llvm::Value *, llvm::Value *>, llvm::AliasResult> _alias_cache;
+    std::vector<PendingEdge> _edges;
+  };
+
+  // per function analyses of the pass manager that runs the DDG
+  struct DataDependencyAnalyses
+  {
+    std::function<llvm::TargetLibraryInfo &(llvm::Function &)> get_tli;
+    std::function<llvm::AssumptionCache &(llvm::Function &)> get_ac;
+    // only the one selected by -pdg-raw is asked for
+    std::function<llvm::MemoryDependenceResults &(llvm::Function &)> get_mem_dep;
+    std::function<llvm::MemorySSA &(llvm::Function &)> get_mssa;
+    // the analyses cached by a new pass manager FunctionAnalysisManager
+    static DataDependencyAnalyses fromFunctionAnalysisManager(llvm::FunctionAnalysisManager &FAM);
+  };
+
+  class DataDependencyGraph : public llvm::ModulePass
+  {
+  public:
+    static char ID;
+    DataDependencyGraph() : llvm::ModulePass(ID) {};
+    void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+    llvm::StringRef getPassName() const override { return "Data Dependency Graph"; }
+    bool runOnModule(llvm::Module &M) override;
+    // add the data edges of every function of M to g, shared by both pass managers
+    void buildDataDependencies(llvm::Module &M, ProgramGraph &g, MemoryReport &mem_report, DataDependencyAnalyses &analyses);
+
+  private:
+    void addEdges(const std::vector<DataEdgeCollector::PendingEdge> &edges);
+    // -pdg-threads: each worker builds its own analyses for the functions it picks up
+    void collectEdgesInParallel(llvm::Module &M, std::vector<llvm::Function *> &funcs, std::vector<std::vector<DataEdgeCollector::PendingEdge>> &func_edges, DataDependencyAnalyses &analyses);
+
+    ProgramGraph *_PDG;
+    AndersenAA _andersen;
+  };
+
+  // -passes=ddg
+  class DataDependencyGraphPass : public llvm::PassInfoMixin<DataDependencyGraphPass>
+  {
+  public:
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &MAM);
   };
 } // namespace pdg
 #endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef FROZENGRAPH_H_
+#define FROZENGRAPH_H_
+#include "LLVMEssentials.hh"
+#include "PDGEnums.hh"
+#include "llvm/ADT/ArrayRef.h"
+#include <vector>
+
+namespace pdg
+{
+  class Node;
+  class Edge;
+
+  // compressed-sparse-row snapshot of a finished graph. Graph nodes get dense indices in
+  // graph iteration order, nodes only reachable through edges (e.g. tree nodes that were never
+  // added to the graph) are appended after them so traversals see the same edges as the
+  // pointer based adjacency.
+  // Besides the edge objects, the snapshot holds range records: edges from one node to a run
+  // of consecutive nodes that have no Edge object. The control dependences recorded per basic
+  // block are kept this way, as the instruction nodes of a block are consecutive.
+  class FrozenGraph
+  {
+  public:
+    struct EdgeRecord
+    {
+      unsigned node; // dst node for out edges, src node for in edges
+      EdgeType edge_type;
+    };
+
+    // edges from src to the nodes first .. first + count - 1
+    struct RangeRecord
+    {
+      unsigned src;
+      unsigned first;
+      unsigned count;
+      EdgeType edge_type;
+    };
+
+    FrozenGraph() = default;
+    // num_node_ids sizes the id -> index table, see GraphArena::numNodeIDs
+    void build(const std::vector<Node *> &graph_nodes, unsigned num_node_ids);
+    // replace the range records, every src and dst must be indexed already. The ranges of a
+    // src are kept in the given order
+    void setRangeEdges(std::vector<RangeRecord> ranges);
+    void clear();
+    unsigned size() const { return _nodes.size(); }
+    unsigned numGraphNodes() const { return _num_graph_nodes; }
+    // including the edges of the range records
+    unsigned numEdges() const { return _out_records.size() + _num_range_edges; }
+    size_t getMemoryUsage() const;
+    Node *getNode(unsigned idx) const { return _nodes[idx]; }
+    bool hasNode(const Node &n) const;
+    unsigned getIndex(const Node &n) const;
+    llvm::ArrayRef<EdgeRecord> getOutEdges(unsigned idx) const { return getRange(_out_records, _out_offsets, idx); }
+    llvm::ArrayRef<EdgeRecord> getInEdges(unsigned idx) const { return getRange(_in_records, _in_offsets, idx); }
+    // edge objects parallel to the records, for consumers that need edge identity
+    llvm::ArrayRef<Edge *> getOutEdgeObjects(unsigned idx) const { return getRange(_out_edges, _out_offsets, idx); }
+    llvm::ArrayRef<Edge *> getInEdgeObjects(unsigned idx) const { return getRange(_in_edges, _in_offsets, idx); }
+    // edges without objects. Out edges are the ranges starting at idx, in edges the sources of
+    // every range that covers idx
+    llvm::ArrayRef<RangeRecord> getOutRangeEdges(unsigned idx) const;
+    llvm::ArrayRef<EdgeRecord> getInRangeEdges(unsigned idx) const;
+
+  private:
+    static constexpr unsigned NOT_INDEXED = ~0U;
+    unsigned indexNode(Node *n);
+    template <typename T>
+    static llvm::ArrayRef<T> getRange(const std::vector<T> &vec, const std::vector<unsigned> &offsets, unsigned idx)
+    {
+      return llvm::makeArrayRef(vec.data() + offsets[idx], offsets[idx + 1] - offsets[idx]);
+    }
+
+    std::vector<Node *> _nodes;
+    std::vector<unsigned> _node_index; // node id -> index, NOT_INDEXED for absent nodes
+    unsigned _num_graph_nodes = 0;
+    std::vector<unsigned> _out_offsets;
+    std::vector<EdgeRecord> _out_records;
+    std::vector<Edge *> _out_edges;
+    std::vector<unsigned> _in_offsets;
+    std::vector<EdgeRecord> _in_records;
+    std::vector<Edge *> _in_edges;
+    // range records sorted by src, _range_offsets is empty while there are none
+    std::vector<unsigned> _range_offsets;
+    std::vector<RangeRecord> _ranges;
+    unsigned _num_range_edges = 0;
+    // the bounds of all ranges cut the node indices into segments, segment i starts at
+    // _segment_bounds[i] and lists the sources of the ranges covering it
+    std::vector<unsigned> _segment_bounds;
+    std::vector<unsigned> _segment_offsets;
+    std::vector<EdgeRecord> _segment_records;
+  };
+} // namespace pdg
+
+#endif
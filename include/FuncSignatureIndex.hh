@@ -0,0 +1,40 @@
+#ifndef FUNCSIGNATUREINDEX_H_
+#define FUNCSIGNATUREINDEX_H_
+#include "LLVMEssentials.hh"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+
+namespace pdg
+{
+  // the address-taken functions of a module keyed by signature, so that the candidates of an
+  // indirect call are one lookup. Pointers to structs are compared by struct name without
+  // the version suffix llvm-link adds, so a struct.foo.1 * parameter matches struct.foo *
+  class FuncSignatureIndex
+  {
+  public:
+    using FuncList = llvm::SmallVector<llvm::Function *, 4>;
+
+    FuncSignatureIndex() = default;
+    FuncSignatureIndex(const FuncSignatureIndex &) = delete;
+    FuncSignatureIndex &operator=(const FuncSignatureIndex &) = delete;
+    // index the defined, non variadic functions of M whose address is taken
+    void build(llvm::Module &M);
+    // functions ci may call, in module order
+    const FuncList &getCandidates(llvm::CallInst &ci);
+    bool isBuild() const { return _is_build; }
+    void clear();
+
+  private:
+    llvm::Type *getCanonicalType(llvm::Type &t);
+    llvm::FunctionType *getSignature(llvm::Type &ret_type, llvm::ArrayRef<llvm::Type *> arg_types);
+
+    llvm::DenseMap<llvm::FunctionType *, FuncList> _funcs_by_signature;
+    llvm::DenseMap<llvm::Type *, llvm::Type *> _canonical_types;
+    llvm::StringMap<llvm::Type *> _struct_ptr_types;
+    FuncList _no_candidates;
+    bool _is_build = false;
+  };
+} // namespace pdg
+
+#endif
@@ -4,26 +4,36 @@
 #include "LLVMEssentials.hh"
 #include "Tree.hh"
 #include "PDGUtils.hh"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
 
 namespace pdg
 {
   class FunctionWrapper
   {
   public:
-    FunctionWrapper(llvm::Function *func)
+    using ArgTreeMap = llvm::MapVector<llvm::Argument *, Tree *>;
+    FunctionWrapper(llvm::Function *func, GraphArena &arena)
     {
       // llvm:: errs() << "Checking for Function: " << *func << "\n";
       _func = func;
+      _arena = &arena;
+      _ret_val_formal_in_tree = nullptr;
+      _ret_val_formal_out_tree = nullptr;
+      _tree_depth = TREEDEPTH;
       for (auto arg_iter = _func->arg_begin(); arg_iter != _func->arg_end(); arg_iter++)
       {
         _arg_list.push_back(&*arg_iter);
       }
-      _entry_node = new Node(*func,GraphNodeType::FUNC_ENTRY);
+      _entry_node = _arena->create<Node>(*_arena, *func, GraphNodeType::FUNC_ENTRY);
       _entry_node->setFunc(*func);
     }
     llvm::Function *getFunc() const { return _func; }
+    GraphArena &getArena() { return *_arena; }
     Node *getEntryNode() { return _entry_node; }
     void addInst(llvm::Instruction &i);
+    // position of i in the instruction order of the function, -1 if i is not one of its instructions
+    int getInstOrdinal(llvm::Instruction &i) const;
     void buildFormalTreeForArgs();
     void buildFormalTreesForRetVal();
     llvm::DIType *getArgDIType(llvm::Argument &arg);
@@ -33,8 +43,9 @@ namespace pdg
     Tree *getArgFormalOutTree(llvm::Argument &arg);
     Tree *getRetFormalInTree() { return _ret_val_formal_in_tree; }
     Tree *getRetFormalOutTree() { return _ret_val_formal_out_tree; }
-    std::map<llvm::Argument *, Tree *> &getArgFormalInTreeMap() { return _arg_formal_in_tree_map; }
-    std::map<llvm::Argument *, Tree *> &getArgFormalOutTreeMap() { return _arg_formal_out_tree_map; }
+    // in argument order
+    ArgTreeMap &getArgFormalInTreeMap() { return _arg_formal_in_tree_map; }
+    ArgTreeMap &getArgFormalOutTreeMap() { return _arg_formal_out_tree_map; }
     std::vector<llvm::AllocaInst *> &getAllocInsts() { return _alloca_insts; }
     std::vector<llvm::DbgDeclareInst *> &getDbgDeclareInsts() { return _dbg_declare_insts; }
     std::vector<llvm::LoadInst *> &getLoadInsts() { return _load_insts; }
@@ -43,8 +54,18 @@ namespace pdg
     std::vector<llvm::ReturnInst *> &getReturnInsts() { return _return_insts; }
     std::vector<llvm::Argument *> &getArgList() { return _arg_list; }
     bool hasNullRetVal() { return (_ret_val_formal_in_tree == nullptr); }
+    // depth of the formal trees and of the actual trees built against this callee, lowered
+    // by -pdg-tree-budget. 0 for no limit
+    int getTreeDepth() const { return _tree_depth; }
+    void setTreeDepth(int depth) { _tree_depth = depth; }
+    // the DITypes the formal trees are grown from, one per argument that gets a tree and one
+    // for the return value
+    std::vector<llvm::DIType *> getTreeRootDITypes();
+    // approximate bytes of the wrapper and its instruction lists / tree maps, not the trees
+    size_t getMemoryUsage() const;
 
   private:
+    GraphArena *_arena;
     Node *_entry_node;
     llvm::Function *_func;
     std::vector<llvm::AllocaInst *> _alloca_insts;
@@ -54,10 +75,12 @@ namespace pdg
     std::vector<llvm::CallInst *> _call_insts;
     std::vector<llvm::ReturnInst *> _return_insts;
     std::vector<llvm::Argument *> _arg_list;
-    std::map<llvm::Argument *, Tree *> _arg_formal_in_tree_map;
-    std::map<llvm::Argument *, Tree *> _arg_formal_out_tree_map;
+    llvm::DenseMap<llvm::Instruction *, unsigned> _inst_ordinals;
+    ArgTreeMap _arg_formal_in_tree_map;
+    ArgTreeMap _arg_formal_out_tree_map;
     Tree *_ret_val_formal_in_tree;
     Tree *_ret_val_formal_out_tree;
+    int _tree_depth;
 
   };
 } // namespace pdg
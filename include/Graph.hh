@@ -8,6 +8,11 @@
 #include "FunctionWrapper.hh"
 #include "PDGEnums.hh"
 #include "PDGCommandLineOptions.hh"
+#include "FrozenGraph.hh"
+#include "GraphArena.hh"
+#include "FuncSignatureIndex.hh"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseSet.h"
 
 #include <fstream>
 #include <unordered_map>
@@ -23,18 +28,26 @@ namespace pdg
   {
   public:
     typedef std::unordered_map<llvm::Value *, Node *> ValueNodeMap;
-    typedef std::set<Edge *> EdgeSet;
-    typedef std::set<Node *> NodeSet;
+    // insertion ordered, so iteration and every export is stable across runs. Membership is
+    // tracked by node / edge id
+    typedef std::vector<Edge *> EdgeSet;
+    typedef std::vector<Node *> NodeSet;
     ValueNodeMap::iterator val_node_map_begin() { return _val_node_map.begin(); }
     ValueNodeMap::iterator val_node_map_end() { return _val_node_map.end(); }
     GenericGraph() = default;
+    virtual ~GenericGraph() = default;
     NodeSet::iterator begin() { return _node_set.begin(); }
     NodeSet::iterator end() { return _node_set.end(); }
-    NodeSet::iterator begin() const { return _node_set.begin(); }
-    NodeSet::iterator end() const { return _node_set.end(); }
+    NodeSet::const_iterator begin() const { return _node_set.begin(); }
+    NodeSet::const_iterator end() const { return _node_set.end(); }
     virtual void build(llvm::Module &M) = 0;
-    void addEdge(Edge &e) { _edge_set.insert(&e); }
-    void addNode(Node &n) { _node_set.insert(&n); }
+    // drop every node, edge and wrapper and release the arena, the graph can then be rebuilt
+    virtual void clear();
+    void addEdge(Edge &e);
+    void addNode(Node &n);
+    // change the type of an edge in place. Drops the frozen snapshot like addNode
+    void setEdgeType(Edge &e, EdgeType edge_type);
+    bool hasNode(Node &n) const;
     Node *getNode(llvm::Value &v);
     bool hasNode(llvm::Value &v);
     int numEdge() { return _edge_set.size(); }
@@ -44,14 +57,36 @@ namespace pdg
     bool canReach(pdg::Node &src, pdg::Node &dst);
     bool canReach(pdg::Node &src, pdg::Node &dst, std::set<EdgeType> exclude_edge_types);
     ValueNodeMap &getValueNodeMap() { return _val_node_map; }
-    EdgeSet getEdgeSet() { return _edge_set; };
+    GraphArena &getArena() { return _arena; }
+    const EdgeSet &getEdgeSet() const { return _edge_set; }
+    const NodeSet &getNodeSet() const { return _node_set; }
     void dumpGraph();
+    // snapshot the adjacency into a CSR layout. The snapshot is not updated by later
+    // addNeighbor calls, so freeze once the graph is complete (addNode drops it)
+    void freeze();
+    // turn every lazily recorded dependence into real edges. The snapshot keeps the records
+    // as they are, and the neighbor views and EdgeIterator of a frozen graph expand them. Code
+    // that needs edge objects for them, or walks the adjacency of a graph that is not frozen,
+    // calls this first
+    virtual void materializeLazyEdges() {}
+    bool isFrozen() { return _is_frozen; }
+    FrozenGraph &getFrozenGraph() { return _frozen_graph; }
 
   protected:
+    // add the lazily recorded dependences to a freshly built snapshot
+    virtual void freezeLazyEdges(FrozenGraph &frozen_graph) {}
+    void thaw();
+
+    // declared first so it is destroyed after every container that points into it
+    GraphArena _arena;
     ValueNodeMap _val_node_map;
     EdgeSet _edge_set;
     NodeSet _node_set;
+    llvm::BitVector _edge_ids;
+    llvm::BitVector _node_ids;
     bool _is_build = false;
+    FrozenGraph _frozen_graph;
+    bool _is_frozen = false;
   };
 
   class ProgramGraph : public GenericGraph
@@ -60,22 +95,29 @@ namespace pdg
     typedef std::unordered_map<llvm::Function *, FunctionWrapper *> FuncWrapperMap;
     typedef std::unordered_map<llvm::CallInst *, CallWrapper *> CallWrapperMap;
     typedef std::unordered_map<Node *, llvm::DIType *> NodeDIMap;
+    // control dependence of every instruction in bb on src. Kept per block until the graph
+    // needs instruction level edges, which saves one edge per instruction of the block
+    struct BlockControlDep
+    {
+      Node *src;
+      llvm::BasicBlock *bb;
+      EdgeType edge_type;
+    };
+    typedef std::vector<BlockControlDep> BlockControlDepList;
 
     ProgramGraph() = default;
     ProgramGraph(const ProgramGraph &) = delete;
     ProgramGraph(ProgramGraph &&) = delete;
     ProgramGraph &operator=(const ProgramGraph &) = delete;
     ProgramGraph &operator=(ProgramGraph &&) = delete;
-    static ProgramGraph &getInstance()
-    {
-      static ProgramGraph g{};
-      return g;
-    }
 
     FuncWrapperMap &getFuncWrapperMap() { return _func_wrapper_map; }
     CallWrapperMap &getCallWrapperMap() { return _call_wrapper_map; }
     NodeDIMap &getNodeDIMap() { return _node_di_type_map; }
+    // every address-taken function of the module by signature, built and cleared with the graph
+    FuncSignatureIndex &getFuncSignatureIndex() { return _func_sig_index; }
     void build(llvm::Module &M) override;
+    void clear() override;
     bool hasFuncWrapper(llvm::Function &F) { return _func_wrapper_map.find(&F) != _func_wrapper_map.end(); }
     bool hasCallWrapper(llvm::CallInst &ci) { return _call_wrapper_map.find(&ci) != _call_wrapper_map.end(); }
     FunctionWrapper *getFuncWrapper(llvm::Function &F) { return _func_wrapper_map[&F]; }
@@ -84,14 +126,36 @@ namespace pdg
     llvm::DIType *computeNodeDIType(Node &n);
     void addTreeNodesToGraph(Tree &tree);
     void addFormalTreeNodesToGraph(FunctionWrapper &func_w);
+    // build the formal trees of func_w and register it, its instructions must be added already
+    void addFunctionWrapper(FunctionWrapper &func_w);
     bool isAnnotationCallInst(llvm::Instruction &inst);
     void buildGlobalAnnotationNodes(llvm::Module &M);
+    llvm::DenseSet<llvm::Function *> computeDemandedFunctions(llvm::Module &M);
+    void allocateTreeDepths(std::vector<FunctionWrapper *> &func_ws);
     void dumpNodeLineNumbers();
+    void addBlockControlDep(Node &src, llvm::BasicBlock &bb, EdgeType edge_type);
+    // give the recorded control edges into nodes of dst_node_type the type edge_type, like
+    // setEdgeType does for real edges
+    void setBlockControlDepType(GraphNodeType dst_node_type, EdgeType edge_type);
+    // deps that are not expanded yet
+    const BlockControlDepList &getBlockControlDeps() const { return _block_control_deps; }
+    size_t getBlockControlDepMemoryUsage() const;
+    void materializeLazyEdges() override;
+
+  protected:
+    // one range record per run of consecutive instruction nodes in each dependent block
+    void freezeLazyEdges(FrozenGraph &frozen_graph) override;
 
   private:
+    EdgeType getBlockControlDepType(Node &dst, EdgeType edge_type) const;
+
     FuncWrapperMap _func_wrapper_map;
     CallWrapperMap _call_wrapper_map;
     NodeDIMap _node_di_type_map;
+    BlockControlDepList _block_control_deps;
+    llvm::DenseSet<std::pair<std::pair<Node *, llvm::BasicBlock *>, unsigned>> _block_control_dep_index;
+    std::vector<std::pair<GraphNodeType, EdgeType>> _block_control_dep_types;
+    FuncSignatureIndex _func_sig_index;
   };
 } // namespace pdg
 
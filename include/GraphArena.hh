@@ -0,0 +1,108 @@
+#ifndef GRAPHARENA_H_
+#define GRAPHARENA_H_
+#include "PDGEnums.hh"
+#include "StringTable.hh"
+#include "TreeShape.hh"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/Support/Allocator.h"
+#include <cstdint>
+#include <utility>
+
+namespace pdg
+{
+  class Node;
+  class TreeNode;
+  class Edge;
+  class Tree;
+  class FunctionWrapper;
+  class CallWrapper;
+  class FrozenGraph;
+
+  // per graph slab storage for nodes, edges, trees and wrappers, plus the strings the nodes
+  // refer to, the debug info type cache and the shapes trees are built from. Objects are
+  // never freed one by one, everything is destroyed together when the owning graph goes away.
+  class GraphArena
+  {
+  public:
+    // (src id << 32 | dst id, edge type)
+    using EdgeKey = std::pair<uint64_t, unsigned>;
+    GraphArena() = default;
+    GraphArena(const GraphArena &) = delete;
+    GraphArena &operator=(const GraphArena &) = delete;
+    ~GraphArena();
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args)
+    {
+      auto &allocator = getAllocator(static_cast<T *>(nullptr));
+      _num_objects[getKind(static_cast<T *>(nullptr))]++;
+      return new (allocator.Allocate()) T(std::forward<Args>(args)...);
+    }
+    // number of objects of type T created since the last reset
+    template <typename T>
+    size_t numCreated() const { return _num_objects[getKind(static_cast<T *>(nullptr))]; }
+    StringTable &getStringTable() { return _string_table; }
+    DITypeCache &getDITypeCache() { return _di_types; }
+    TreeShapeCache &getTreeShapes() { return _tree_shapes; }
+    // node and edge ids are dense and zero based per graph, so side tables can be vectors
+    // indexed by id and sized with numNodeIDs() / numEdgeIDs()
+    unsigned allocNodeID() { return _num_node_ids++; }
+    unsigned allocEdgeID() { return _num_edge_ids++; }
+    unsigned numNodeIDs() const { return _num_node_ids; }
+    unsigned numEdgeIDs() const { return _num_edge_ids; }
+    // one entry per (src, dst, type) edge created by Node::addNeighbor, which drops duplicates
+    // with it. Returns false if the edge was already there
+    bool insertEdgeKey(unsigned src_id, unsigned dst_id, EdgeType edge_type) { return _edge_keys.insert(makeEdgeKey(src_id, dst_id, edge_type)).second; }
+    void eraseEdgeKey(unsigned src_id, unsigned dst_id, EdgeType edge_type) { _edge_keys.erase(makeEdgeKey(src_id, dst_id, edge_type)); }
+    bool hasEdgeKey(unsigned src_id, unsigned dst_id, EdgeType edge_type) const { return _edge_keys.count(makeEdgeKey(src_id, dst_id, edge_type)) != 0; }
+    const llvm::DenseSet<EdgeKey> &getEdgeKeys() const { return _edge_keys; }
+    // snapshot of the owning graph while it is frozen, so node level iterators can follow the
+    // edges that only exist in the snapshot
+    const FrozenGraph *getFrozenGraph() const { return _frozen_graph; }
+    void setFrozenGraph(const FrozenGraph *frozen_graph) { _frozen_graph = frozen_graph; }
+    // run the destructors of all objects and release the slabs
+    void reset();
+
+  private:
+    enum ObjectKind
+    {
+      NODE,
+      TREE_NODE,
+      EDGE,
+      TREE,
+      FUNC_WRAPPER,
+      CALL_WRAPPER,
+      NUM_OBJECT_KINDS
+    };
+    static EdgeKey makeEdgeKey(unsigned src_id, unsigned dst_id, EdgeType edge_type) { return EdgeKey((static_cast<uint64_t>(src_id) << 32) | dst_id, static_cast<unsigned>(edge_type)); }
+    static ObjectKind getKind(Node *) { return NODE; }
+    static ObjectKind getKind(TreeNode *) { return TREE_NODE; }
+    static ObjectKind getKind(Edge *) { return EDGE; }
+    static ObjectKind getKind(Tree *) { return TREE; }
+    static ObjectKind getKind(FunctionWrapper *) { return FUNC_WRAPPER; }
+    static ObjectKind getKind(CallWrapper *) { return CALL_WRAPPER; }
+    llvm::SpecificBumpPtrAllocator<Node> &getAllocator(Node *) { return _node_alloc; }
+    llvm::SpecificBumpPtrAllocator<TreeNode> &getAllocator(TreeNode *) { return _tree_node_alloc; }
+    llvm::SpecificBumpPtrAllocator<Edge> &getAllocator(Edge *) { return _edge_alloc; }
+    llvm::SpecificBumpPtrAllocator<Tree> &getAllocator(Tree *) { return _tree_alloc; }
+    llvm::SpecificBumpPtrAllocator<FunctionWrapper> &getAllocator(FunctionWrapper *) { return _func_wrapper_alloc; }
+    llvm::SpecificBumpPtrAllocator<CallWrapper> &getAllocator(CallWrapper *) { return _call_wrapper_alloc; }
+
+    llvm::SpecificBumpPtrAllocator<Node> _node_alloc;
+    llvm::SpecificBumpPtrAllocator<TreeNode> _tree_node_alloc;
+    llvm::SpecificBumpPtrAllocator<Edge> _edge_alloc;
+    llvm::SpecificBumpPtrAllocator<Tree> _tree_alloc;
+    llvm::SpecificBumpPtrAllocator<FunctionWrapper> _func_wrapper_alloc;
+    llvm::SpecificBumpPtrAllocator<CallWrapper> _call_wrapper_alloc;
+    StringTable _string_table;
+    DITypeCache _di_types;
+    TreeShapeCache _tree_shapes{_di_types};
+    unsigned _num_node_ids = 0;
+    unsigned _num_edge_ids = 0;
+    llvm::DenseSet<EdgeKey> _edge_keys;
+    const FrozenGraph *_frozen_graph = nullptr;
+    size_t _num_objects[NUM_OBJECT_KINDS] = {};
+  };
+} // namespace pdg
+
+#endif
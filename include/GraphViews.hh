@@ -0,0 +1,212 @@
+#ifndef GRAPHVIEWS_H_
+#define GRAPHVIEWS_H_
+#include "PDGEdge.hh"
+#include "PDGEnums.hh"
+#include "FrozenGraph.hh"
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace pdg
+{
+  class Node;
+
+  // a set of edge types, one bit per EdgeType
+  class EdgeTypeMask
+  {
+  public:
+    EdgeTypeMask() : _bits(0) {}
+    EdgeTypeMask(EdgeType edge_type) : _bits(bit(edge_type)) {}
+    EdgeTypeMask(std::initializer_list<EdgeType> edge_types) : _bits(0)
+    {
+      for (auto edge_type : edge_types)
+        insert(edge_type);
+    }
+    static EdgeTypeMask all()
+    {
+      EdgeTypeMask mask;
+      mask._bits = ~0U;
+      return mask;
+    }
+    void insert(EdgeType edge_type) { _bits |= bit(edge_type); }
+    bool contains(EdgeType edge_type) const { return (_bits & bit(edge_type)) != 0; }
+    bool isAll() const { return _bits == ~0U; }
+    EdgeTypeMask operator~() const
+    {
+      EdgeTypeMask mask;
+      mask._bits = ~_bits;
+      return mask;
+    }
+
+  private:
+    static uint32_t bit(EdgeType edge_type) { return 1U << static_cast<unsigned>(edge_type); }
+    uint32_t _bits;
+  };
+  static_assert(static_cast<unsigned>(EdgeType::TYPE_OTHEREDGE) < 32, "EdgeTypeMask holds 32 edge types");
+
+  // non-owning view over an edge list that skips edges whose type is not in the mask. It does
+  // not allocate and stays valid as long as the underlying list is not modified. With
+  // to_src set the range yields the source node of each edge, otherwise the dst node.
+  template <typename T>
+  class FilteredEdgeRange
+  {
+  public:
+    class iterator
+    {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = T *;
+      using difference_type = std::ptrdiff_t;
+      using pointer = T **;
+      using reference = T *;
+
+      iterator(Edge *const *cur, Edge *const *end, EdgeTypeMask mask, bool to_src) : _cur(cur), _end(end), _mask(mask), _to_src(to_src) { skip(); }
+      T *operator*() const { return deref(*_cur); }
+      Edge *getEdge() const { return *_cur; }
+      iterator &operator++()
+      {
+        ++_cur;
+        skip();
+        return *this;
+      }
+      iterator operator++(int)
+      {
+        iterator old = *this;
+        ++*this;
+        return old;
+      }
+      bool operator==(const iterator &r) const { return _cur == r._cur; }
+      bool operator!=(const iterator &r) const { return _cur != r._cur; }
+
+    private:
+      void skip()
+      {
+        while (_cur != _end && !_mask.contains((*_cur)->getEdgeType()))
+          ++_cur;
+      }
+      T *deref(Edge *e) const;
+
+      Edge *const *_cur;
+      Edge *const *_end;
+      EdgeTypeMask _mask;
+      bool _to_src;
+    };
+
+    FilteredEdgeRange(const std::vector<Edge *> &edges, EdgeTypeMask mask, bool to_src = false)
+        : _begin(edges.data()), _end(edges.data() + edges.size()), _mask(mask), _to_src(to_src) {}
+    iterator begin() const { return iterator(_begin, _end, _mask, _to_src); }
+    iterator end() const { return iterator(_end, _end, _mask, _to_src); }
+    bool empty() const { return begin() == end(); }
+
+  private:
+    Edge *const *_begin;
+    Edge *const *_end;
+    EdgeTypeMask _mask;
+    bool _to_src;
+  };
+
+  template <>
+  inline Edge *FilteredEdgeRange<Edge>::iterator::deref(Edge *e) const { return e; }
+  template <>
+  inline Node *FilteredEdgeRange<Node>::iterator::deref(Edge *e) const { return _to_src ? e->getSrcNode() : e->getDstNode(); }
+
+  using EdgeRange = FilteredEdgeRange<Edge>;
+
+  // the neighbors behind a node's edge objects and, while its graph is frozen, the ones its
+  // range records in the snapshot lead to (out) or come from (in). Does not allocate and stays
+  // valid as long as neither the edge list nor the snapshot change
+  class NeighborRange
+  {
+  public:
+    using RangeRecord = FrozenGraph::RangeRecord;
+    using EdgeRecord = FrozenGraph::EdgeRecord;
+
+    class iterator
+    {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = Node *;
+      using difference_type = std::ptrdiff_t;
+      using pointer = Node **;
+      using reference = Node *;
+
+      iterator(FilteredEdgeRange<Node>::iterator edge_iter, FilteredEdgeRange<Node>::iterator edge_end, const FrozenGraph *frozen_graph,
+               llvm::ArrayRef<RangeRecord> ranges, llvm::ArrayRef<EdgeRecord> records, EdgeTypeMask mask)
+          : _edge_iter(edge_iter), _edge_end(edge_end), _frozen_graph(frozen_graph), _range(ranges.begin()), _range_end(ranges.end()),
+            _range_pos(0), _record(records.begin()), _record_end(records.end()), _mask(mask) { skip(); }
+      Node *operator*() const
+      {
+        if (_edge_iter != _edge_end)
+          return *_edge_iter;
+        if (_range != _range_end)
+          return _frozen_graph->getNode(_range->first + _range_pos);
+        return _frozen_graph->getNode(_record->node);
+      }
+      iterator &operator++()
+      {
+        if (_edge_iter != _edge_end)
+          ++_edge_iter;
+        else if (_range != _range_end)
+        {
+          if (++_range_pos == _range->count)
+          {
+            ++_range;
+            _range_pos = 0;
+          }
+        }
+        else
+          ++_record;
+        skip();
+        return *this;
+      }
+      iterator operator++(int)
+      {
+        iterator old = *this;
+        ++*this;
+        return old;
+      }
+      bool operator==(const iterator &r) const { return _edge_iter == r._edge_iter && _range == r._range && _range_pos == r._range_pos && _record == r._record; }
+      bool operator!=(const iterator &r) const { return !(*this == r); }
+
+    private:
+      void skip()
+      {
+        if (_edge_iter != _edge_end)
+          return;
+        while (_range != _range_end && !_mask.contains(_range->edge_type))
+          ++_range;
+        if (_range != _range_end)
+          return;
+        while (_record != _record_end && !_mask.contains(_record->edge_type))
+          ++_record;
+      }
+
+      FilteredEdgeRange<Node>::iterator _edge_iter;
+      FilteredEdgeRange<Node>::iterator _edge_end;
+      const FrozenGraph *_frozen_graph;
+      const RangeRecord *_range;
+      const RangeRecord *_range_end;
+      unsigned _range_pos;
+      const EdgeRecord *_record;
+      const EdgeRecord *_record_end;
+      EdgeTypeMask _mask;
+    };
+
+    // ranges for out neighbors, records for in neighbors
+    NeighborRange(const std::vector<Edge *> &edges, EdgeTypeMask mask, bool to_src, const FrozenGraph *frozen_graph,
+                  llvm::ArrayRef<RangeRecord> ranges, llvm::ArrayRef<EdgeRecord> records)
+        : _edges(edges, mask, to_src), _frozen_graph(frozen_graph), _ranges(ranges), _records(records), _mask(mask) {}
+    iterator begin() const { return iterator(_edges.begin(), _edges.end(), _frozen_graph, _ranges, _records, _mask); }
+    iterator end() const { return iterator(_edges.end(), _edges.end(), _frozen_graph, llvm::makeArrayRef(_ranges.end(), size_t(0)), llvm::makeArrayRef(_records.end(), size_t(0)), _mask); }
+    bool empty() const { return begin() == end(); }
+
+  private:
+    FilteredEdgeRange<Node> _edges;
+    const FrozenGraph *_frozen_graph;
+    llvm::ArrayRef<RangeRecord> _ranges;
+    llvm::ArrayRef<EdgeRecord> _records;
+    EdgeTypeMask _mask;
+  };
+} // namespace pdg
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef MEMORYREPORT_H_
+#define MEMORYREPORT_H_
+#include "LLVMEssentials.hh"
+#include "Graph.hh"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace pdg
+{
+  // -pdg-mem-report: object counts and bytes of each graph structure plus the peak RSS at the
+  // phase boundaries of the graph passes. Bytes are the object size plus the capacity of the
+  // containers it owns, allocator and malloc overhead is not included.
+  class MemoryReport
+  {
+  public:
+    struct Usage
+    {
+      size_t count = 0;
+      size_t bytes = 0;
+      void add(size_t obj_bytes, size_t num = 1)
+      {
+        count += num;
+        bytes += obj_bytes;
+      }
+    };
+
+    struct Phase
+    {
+      std::string name;
+      size_t peak_rss;
+      size_t malloc_bytes;
+      size_t num_nodes;
+      size_t num_edges;
+    };
+
+    void clear();
+    // snapshot the process memory and the graph size at the end of a phase
+    void recordPhase(llvm::StringRef name, ProgramGraph &g);
+    // walk the graph and account every structure it owns
+    void computeFootprint(ProgramGraph &g);
+    void print(llvm::raw_ostream &os) const;
+    void writeJSON(llvm::raw_ostream &os) const;
+    bool writeJSONFile(llvm::StringRef filename) const;
+    static size_t getPeakRSS();
+
+  private:
+    std::vector<Phase> _phases;
+    std::map<GraphNodeType, Usage> _nodes;
+    std::map<GraphNodeType, Usage> _tree_nodes;
+    std::map<EdgeType, Usage> _edges;
+    std::map<std::string, Usage> _structures; // trees, wrappers, maps, strings
+    size_t _total_bytes = 0;
+  };
+} // namespace pdg
+
+#endif
@@ -10,20 +10,15 @@ namespace pdg
   {
   public:
     using PathVecs = std::vector<std::vector<llvm::Function *>>;
-    PDGCallGraph() = default;
+    // indirect calls are resolved through func_sig_index, usually the one of the ProgramGraph
+    explicit PDGCallGraph(FuncSignatureIndex &func_sig_index) : _func_sig_index(func_sig_index) {}
     PDGCallGraph(const PDGCallGraph &) = delete;
     PDGCallGraph(PDGCallGraph &&) = delete;
     PDGCallGraph &operator=(const PDGCallGraph &) = delete;
     PDGCallGraph &operator=(PDGCallGraph &&) = delete;
-    static PDGCallGraph &getInstance()
-    {
-      static PDGCallGraph g{};
-      return g;
-    }
     void build(llvm::Module &M) override;
-    std::set<llvm::Function *> getIndirectCallCandidates(llvm::CallInst &ci, llvm::Module &M);
-    bool isFuncSignatureMatch(llvm::CallInst &ci, llvm::Function &f);
-    bool isTypeEqual(llvm::Type &t1, llvm::Type &t2);
+    // in module order
+    const FuncSignatureIndex::FuncList &getIndirectCallCandidates(llvm::CallInst &ci, llvm::Module &M);
     bool canReach(Node &src, Node &sink);
     void dump();
     void printPaths(Node &src, Node &sink);
@@ -31,6 +26,7 @@ namespace pdg
     void computePathsHelper(PathVecs &path_vecs, Node &src, Node &sink, std::vector<llvm::Function *> cur_path, std::unordered_set<llvm::Function *> visited_funcs, bool &found_path);
 
   private:
+    FuncSignatureIndex &_func_sig_index;
   };
 } // namespace pdg
 
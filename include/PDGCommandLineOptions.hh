@@ -1,11 +1,21 @@
 #ifndef PDGCMDOPTIONS_H_
 #define PDGCMDOPTIONS_H_
+#include "PDGEnums.hh"
 
 namespace pdg
 {
   extern bool DOTONLYDDG;
   extern bool DOTONLYCDG;
   extern bool DEBUG;
+  extern bool MEMREPORT;
+  extern AliasBackend ALIASBACKEND;
+  extern unsigned THREADS;
+  extern RAWBackend RAWBACKEND;
+  extern unsigned MEMSSAWALKLIMIT;
+  extern bool DEMAND;
+  extern unsigned TREEDEPTH;
+  extern unsigned TREETYPEBUDGET;
+  extern unsigned TREEBUDGET;
 }
 
 #endif
\ No newline at end of file
@@ -1,6 +1,5 @@
 #ifndef PDGEDGE_H_
 #define PDGEDGE_H_
-#include "PDGNode.hh"
 #include "PDGEnums.hh"
 
 namespace pdg
@@ -12,27 +11,27 @@ namespace pdg
     EdgeType _edge_type;
     Node *_source;
     Node *_dst;
-    static unsigned int edge_count;
     unsigned int edge_ID;
 
   public:
     Edge() = delete;
-    Edge(Node *source, Node *dst, EdgeType edge_type)
+    // edge_id comes from the owning graph's arena, ids are dense and start at 0
+    Edge(Node *source, Node *dst, EdgeType edge_type, unsigned int edge_id)
     {
       _source = source;
       _dst = dst;
       _edge_type = edge_type;
-      edge_count--;
-      edge_ID = edge_count;
+      edge_ID = edge_id;
     }
     Edge(const Edge &e) // copy constructor
     {
       _source = e.getSrcNode();
       _dst = e.getDstNode();
       _edge_type = e.getEdgeType();
+      edge_ID = e.getEdgeID();
     }
 
-    unsigned int getEdgeID()  { return edge_ID;}
+    unsigned int getEdgeID() const { return edge_ID; }
     EdgeType getEdgeType() const { return _edge_type; }
     void setEdgeType(EdgeType newEdgeType)  { _edge_type = newEdgeType; }
     Node *getSrcNode() const { return _source; }
@@ -60,6 +60,22 @@ namespace pdg
     DATA_READ,
     DATA_WRITE
   };
+
+  // alias query used by the DDG to add DATA_ALIAS edges, see -pdg-alias
+  enum class AliasBackend
+  {
+    UNDERAPPROX,
+    BASICAA,
+    TBAA,
+    ANDERS
+  };
+
+  // source of the DATA_RAW edges, see -pdg-raw
+  enum class RAWBackend
+  {
+    MEMDEP,
+    MEMSSA
+  };
 }
 
 #endif
\ No newline at end of file
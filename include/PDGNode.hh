@@ -5,8 +5,12 @@
 #include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/IR/Metadata.h>
 #include "PDGEdge.hh"
+#include "GraphViews.hh"
 #include "PDGEnums.hh"
+#include "GraphArena.hh"
+#include "FrozenGraph.hh"
 #include <set>
+#include <vector>
 #include <iterator>
 
 
@@ -19,29 +23,31 @@ namespace pdg
   class Node
   {
   public:
-    using EdgeSet = std::set<Edge *>;
+    // edges in insertion order, addNeighbor filters duplicates through the edge keys of the arena
+    using EdgeSet = std::vector<Edge *>;
     using iterator = EdgeIterator<Node>;
     using const_iterator = EdgeIterator<Node>;
 
-    Node(GraphNodeType node_type)
+    Node(GraphArena &arena, GraphNodeType node_type)
     {
+      _arena = &arena;
       _val = nullptr;
       _node_type = node_type;
       _is_visited = false;
       _func = nullptr;
       _node_di_type = nullptr;
-      node_count++;
-      node_ID = node_count;
-      _annotation = "None";
+      node_ID = _arena->allocNodeID();
+      _annotation_id = StringTable::NONE;
       _line_number = -1;
       _col_number = -1;
-      _file_name = "Not Found";
+      _file_name_id = StringTable::NOT_FOUND;
       _paramIdx = -1;
       _inst_index = -1;
     }
 
-    Node(llvm::Value &v, GraphNodeType node_type)
+    Node(GraphArena &arena, llvm::Value &v, GraphNodeType node_type)
     {
+      _arena = &arena;
       _val = &v;
       if (auto inst = llvm::dyn_cast<llvm::Instruction>(&v))
         _func = inst->getFunction();
@@ -52,9 +58,9 @@ namespace pdg
       _node_type = node_type;
       _is_visited = false;
       _node_di_type = nullptr;
-      node_count++;
-      node_ID = node_count;
-      _annotation = "None";
+      node_ID = _arena->allocNodeID();
+      _annotation_id = StringTable::NONE;
+      _file_name_id = StringTable::EMPTY;
       _paramIdx = -1;
       _line_number = -1;
       _col_number = -1;
@@ -66,9 +72,7 @@ namespace pdg
         const llvm::DebugLoc &debugInfo = instruction->getDebugLoc();
         // llvm:: errs() << "debug: " << debugInfo << "\n";
         if(debugInfo) {
-          std::string directory = debugInfo->getDirectory().str();
-          std::string filePath = debugInfo->getFilename().str();
-          _file_name = directory + "/" + filePath;
+          _file_name_id = _arena->getStringTable().internFilePath(debugInfo->getFile());
           _line_number = debugInfo->getLine();
           _col_number = debugInfo->getColumn();
           // llvm:: errs() << "line number: " << _line_number << "\n";
@@ -82,11 +86,9 @@ namespace pdg
           {
             // llvm::DebugLoc Loc(Dbg);
             // auto *scope = llvm::cast<llvm::DIScope>(Loc->getScope());
-            std::string directory = debugInfo->getDirectory().str();
-            std::string filePath = debugInfo->getFilename().str();
             // filename = Loc.getDirectory().str() + "/" + Loc.getFilename().str();
             _line_number = debugInfo->getLine();
-            _file_name = directory + "/" + filePath;
+            _file_name_id = _arena->getStringTable().internFilePath(debugInfo->getFile());
           }
       }
       else if( node_type == pdg::GraphNodeType::VAR_STATICALLOCGLOBALSCOPE || 
@@ -111,29 +113,27 @@ namespace pdg
             }
           }
 
-          std::string directory = dbgGV->getDirectory().str();
-          std::string filePath = dbgGV->getFilename().str();
           _line_number = dbgGV->getLine();
-          _file_name = directory + "/" + filePath;
+          _file_name_id = _arena->getStringTable().internFilePath(dbgGV->getFile());
 
         }
       else
       {
         _line_number = -1;
-        _file_name = "Not Found";
+        _file_name_id = StringTable::NOT_FOUND;
       }
     }
 
     
     int getParamIdx() { return _paramIdx;}
     void setParamIdx(int new_idx) { _paramIdx = new_idx;}
-    void setAnno(std::string new_anno) {  _annotation = new_anno; }
-    std::string getAnno() { return _annotation; }
-    unsigned int getNodeID()  { return node_ID;}
-    void addInEdge(Edge &e) { _in_edge_set.insert(&e); }
-    void addOutEdge(Edge &e) { _out_edge_set.insert(&e); }
-    EdgeSet &getInEdgeSet() { return _in_edge_set; }
-    EdgeSet &getOutEdgeSet() { return _out_edge_set; }
+    void setAnno(llvm::StringRef new_anno) { _annotation_id = _arena->getStringTable().intern(new_anno); }
+    std::string getAnno() { return _arena->getStringTable().get(_annotation_id).str(); }
+    bool hasAnno() { return _annotation_id != StringTable::NONE; }
+    unsigned int getNodeID() const { return node_ID; }
+    GraphArena &getArena() { return *_arena; }
+    void addInEdge(Edge &e) { _in_edge_set.push_back(&e); }
+    void addOutEdge(Edge &e) { _out_edge_set.push_back(&e); }
     void setNodeType(GraphNodeType node_type) { _node_type = node_type; }
     GraphNodeType getNodeType() const { return _node_type; }
     bool isVisited() { return _is_visited; }
@@ -143,24 +143,42 @@ namespace pdg
     llvm::DIType *getDIType() const { return _node_di_type; }
     void setDIType(llvm::DIType &di_type) { _node_di_type = &di_type; }
     void addNeighbor(Node &neighbor, EdgeType edge_type);
+    // retype one of the out edges, keeping the edge keys of the arena in step
+    void setOutEdgeType(Edge &edge, EdgeType edge_type);
     EdgeSet::iterator begin() { return _out_edge_set.begin(); }
     EdgeSet::iterator end() { return _out_edge_set.end(); }
     EdgeSet::const_iterator begin() const { return _out_edge_set.begin(); }
     EdgeSet::const_iterator end() const { return _out_edge_set.end(); }
-    std::set<Node *> getInNeighbors();
-    std::set<Node *> getInNeighborsWithDepType(EdgeType edge_type);
-    std::set<Node *> getOutNeighbors();
-    std::set<Node *> getOutNeighborsWithDepType(EdgeType edge_type);
+    // allocation free views over the adjacency. A node joined by edges of several types
+    // shows up once per edge. The WithDepType views hold each neighbor once, unless
+    // setOutEdgeType gave two edges to the same neighbor the same type.
+    // The edge views only cover edge objects. The neighbor views add the control dependences
+    // a frozen ProgramGraph keeps as range records; on a graph that is not frozen those only
+    // show up once ProgramGraph::materializeLazyEdges turned them into edges
+    EdgeRange getInEdges(EdgeTypeMask mask = EdgeTypeMask::all()) const { return EdgeRange(_in_edge_set, mask); }
+    EdgeRange getOutEdges(EdgeTypeMask mask = EdgeTypeMask::all()) const { return EdgeRange(_out_edge_set, mask); }
+    NeighborRange getInNeighbors(EdgeTypeMask mask = EdgeTypeMask::all()) const { return NeighborRange(_in_edge_set, mask, true, _arena->getFrozenGraph(), {}, getFrozenInRecords()); }
+    NeighborRange getOutNeighbors(EdgeTypeMask mask = EdgeTypeMask::all()) const { return NeighborRange(_out_edge_set, mask, false, _arena->getFrozenGraph(), getFrozenOutRanges(), {}); }
+    NeighborRange getInNeighborsWithDepType(EdgeType edge_type) const { return getInNeighbors(edge_type); }
+    NeighborRange getOutNeighborsWithDepType(EdgeType edge_type) const { return getOutNeighbors(edge_type); }
     bool hasInNeighborWithEdgeType(Node &n, EdgeType edge_type);
     bool hasOutNeighborWithEdgeType(Node &n, EdgeType edge_type);
     int getLineNumber() {return _line_number;};
     int getColumnNumber() {return _col_number;};
     int getInstructionIndex() {return _inst_index;};
     void setInstructionIndex(int index) {_inst_index = index;};
-    std::string getFileName() {return _file_name;};
+    std::string getFileName() {return _arena->getStringTable().get(_file_name_id).str();};
+    virtual bool isTreeNode() const { return false; }
+    // approximate bytes of the node and the containers it owns
+    virtual size_t getMemoryUsage() const;
     virtual ~Node() = default;
 
   protected:
+    // the range records of this node in the snapshot of its graph, empty while it is not frozen
+    llvm::ArrayRef<FrozenGraph::RangeRecord> getFrozenOutRanges() const;
+    llvm::ArrayRef<FrozenGraph::EdgeRecord> getFrozenInRecords() const;
+
+    GraphArena *_arena;
     llvm::Value *_val;
     llvm::Function *_func;
     bool _is_visited;
@@ -168,43 +186,71 @@ namespace pdg
     EdgeSet _out_edge_set;
     GraphNodeType _node_type;
     llvm::DIType *_node_di_type;
-    static unsigned int node_count;
     unsigned int node_ID;
-    std::string _annotation;
+    unsigned _annotation_id;
     int _line_number;
     int _col_number;
     int _inst_index;
-    std::string _file_name;
+    unsigned _file_name_id;
     int _paramIdx;
   };
 
-  // used to iterate through all neighbors (used in dot pdg printer)
+  // used to iterate through all neighbors (used in dot pdg printer). While the graph is
+  // frozen the range records of the snapshot follow the edge objects
   template <typename NodeTy>
   class EdgeIterator : public std::iterator<std::input_iterator_tag, NodeTy>
   {
     typename Node::EdgeSet::iterator _edge_iter;
+    typename Node::EdgeSet::iterator _edge_end;
+    const FrozenGraph *_frozen_graph;
+    const FrozenGraph::RangeRecord *_range_iter;
+    unsigned _range_pos;
     typedef EdgeIterator<NodeTy> this_type;
 
+    static llvm::ArrayRef<FrozenGraph::RangeRecord> getRanges(NodeTy *N)
+    {
+      auto frozen_graph = N->getArena().getFrozenGraph();
+      if (frozen_graph == nullptr || !frozen_graph->hasNode(*N))
+        return {};
+      return frozen_graph->getOutRangeEdges(frozen_graph->getIndex(*N));
+    }
+
+    void next()
+    {
+      if (_edge_iter != _edge_end)
+      {
+        _edge_iter++;
+        return;
+      }
+      if (++_range_pos == _range_iter->count)
+      {
+        _range_iter++;
+        _range_pos = 0;
+      }
+    }
+
   public:
-    EdgeIterator(NodeTy *N) : _edge_iter(N->begin()) {}
-    EdgeIterator(NodeTy *N, bool) : _edge_iter(N->end()) {}
+    EdgeIterator(NodeTy *N) : _edge_iter(N->begin()), _edge_end(N->end()), _frozen_graph(N->getArena().getFrozenGraph()), _range_iter(getRanges(N).begin()), _range_pos(0) {}
+    EdgeIterator(NodeTy *N, bool) : _edge_iter(N->end()), _edge_end(N->end()), _frozen_graph(N->getArena().getFrozenGraph()), _range_iter(getRanges(N).end()), _range_pos(0) {}
 
     this_type &operator++()
     {
-      _edge_iter++;
+      next();
       return *this;
     }
 
     this_type operator++(int)
     {
       this_type old = *this;
-      _edge_iter++;
+      next();
       return old;
     }
 
     Node *operator*()
     {
-      return (*_edge_iter)->getDstNode();
+      if (_edge_iter != _edge_end)
+        return (*_edge_iter)->getDstNode();
+      return _frozen_graph->getNode(_range_iter->first + _range_pos);
     }
 
     Node *operator->()
@@ -214,7 +260,7 @@ namespace pdg
 
     bool operator!=(const this_type &r) const
     {
-      return _edge_iter != r._edge_iter;
+      return _edge_iter != r._edge_iter || _range_iter != r._range_iter || _range_pos != r._range_pos;
     }
 
     bool operator==(const this_type &r) const
@@ -224,7 +270,9 @@ namespace pdg
 
     EdgeType getEdgeType()
     {
-      return (*_edge_iter)->getEdgeType();
+      if (_edge_iter != _edge_end)
+        return (*_edge_iter)->getEdgeType();
+      return _range_iter->edge_type;
     }
   };
 
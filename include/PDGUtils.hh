@@ -25,9 +25,8 @@ namespace pdg
     bool isStaticFuncVar(llvm::GlobalVariable &gv, llvm::Module &M);
     bool isStaticGlobalVar(llvm::GlobalVariable &gv);
     llvm::inst_iterator getInstIter(llvm::Instruction &i);
-    std::set<llvm::Instruction *> getInstructionBeforeInst(llvm::Instruction &i);
-    std::set<llvm::Instruction *> getInstructionAfterInst(llvm::Instruction &i);
-    std::set<llvm::Value *> computeAddrTakenVarsFromAlloc(llvm::AllocaInst &ai);
+    // the loads of ai in use list order
+    std::vector<llvm::Value *> computeAddrTakenVarsFromAlloc(llvm::AllocaInst &ai);
     void printTreeNodesLabel(Node* n, llvm::raw_string_ostream &OS, std::string tree_node_type_str);
     llvm::Value *getLShrOnGep(llvm::GetElementPtrInst &gep);
     std::string stripFuncNameVersionNumber(std::string func_name);
@@ -36,6 +35,16 @@ namespace pdg
     std::string getNodeTypeStr(GraphNodeType node_type);
     std::string getEdgeTypeStr(EdgeType edge_type);
     std::string& rtrim(std::string& s, const char* t = "\t\n\r\f\v");
+
+    // rough per element heap overhead of the std containers, used by the memory report
+    constexpr size_t kRBTreeNodeOverhead = 4 * sizeof(void *);
+    template <typename MapTy>
+    size_t getMapMemoryUsage(const MapTy &map) { return map.size() * (sizeof(typename MapTy::value_type) + kRBTreeNodeOverhead); }
+    // a MapVector keeps an index entry per element next to the element vector
+    template <typename MapTy>
+    size_t getMapVectorMemoryUsage(const MapTy &map) { return map.size() * (sizeof(typename MapTy::value_type) + sizeof(std::pair<typename MapTy::key_type, unsigned>)); }
+    template <typename MapTy>
+    size_t getHashMapMemoryUsage(const MapTy &map) { return map.bucket_count() * sizeof(void *) + map.size() * (sizeof(typename MapTy::value_type) + sizeof(void *)); }
   } // namespace pdgutils
 } // namespace pdg
 
@@ -5,6 +5,7 @@
 #include "PDGCallGraph.hh"
 #include "DataDependencyGraph.hh"
 #include "ControlDependencyGraph.hh"
+#include <functional>
 
 namespace pdg
 {
@@ -15,14 +16,14 @@ namespace pdg
       ProgramDependencyGraph() : llvm::ModulePass(ID) {};
       bool runOnModule(llvm::Module &M) override;
       void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+      // connect the control and interprocedural dependencies of M on a graph that already has
+      // its data edges, then freeze it. Shared by both pass managers
+      void buildPDG(llvm::Module &M, ProgramGraph &g, MemoryReport &mem_report, std::function<llvm::PostDominatorTree &(llvm::Function &)> get_pdt);
       ProgramGraph *getPDG() { return _PDG; }
       llvm::StringRef getPassName() const override { return "Program Dependency Graph"; }
       FunctionWrapper *getFuncWrapper(llvm::Function &F) { return _PDG->getFuncWrapperMap()[&F]; }
       CallWrapper *getCallWrapper(llvm::CallInst &call_inst) { return _PDG->getCallWrapperMap()[&call_inst]; }
 
-      bool isTypeEqual(llvm::Type& t1, llvm::Type &t2);
-      bool isFuncSignatureMatch(llvm::CallInst &ci, llvm::Function &f);
-
       void connectGlobalWithUses();
       void populateInitializerMap();
       void connectInTrees(Tree *src_tree, Tree *dst_tree, EdgeType edge_type);
@@ -41,7 +42,16 @@ namespace pdg
     private:
       llvm::Module *_module;
       ProgramGraph *_PDG;
+      ControlDependencyGraph _cdg;
+      std::function<llvm::PostDominatorTree &(llvm::Function &)> _get_pdt;
       std::map<llvm::Value *, llvm::GlobalVariable *> initializer_map;
   };
+
+  // -passes=pdg, runs the ddg pass first unless it already ran on this module
+  class ProgramDependencyGraphPass : public llvm::PassInfoMixin<ProgramDependencyGraphPass>
+  {
+    public:
+      llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &MAM);
+  };
 }
 #endif
\ No newline at end of file
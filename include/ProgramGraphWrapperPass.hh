@@ -0,0 +1,56 @@
+#ifndef PROGRAMGRAPHWRAPPERPASS_H_
+#define PROGRAMGRAPHWRAPPERPASS_H_
+#include "LLVMEssentials.hh"
+#include "Graph.hh"
+#include "MemoryReport.hh"
+#include <memory>
+
+namespace pdg
+{
+  // holds the ProgramGraph shared by the ddg, cdg and pdg passes. The graph is cleared when a
+  // new module starts, so one pass manager (or process) can analyse many modules in a row.
+  // By default the pass owns the graph and frees it once the module is done; a caller that
+  // wants to keep the graph around can hand in its own instance instead.
+  class ProgramGraphWrapperPass : public llvm::ImmutablePass
+  {
+  public:
+    static char ID;
+    ProgramGraphWrapperPass();
+    explicit ProgramGraphWrapperPass(ProgramGraph &g);
+    llvm::StringRef getPassName() const override { return "Program Graph Storage"; }
+    bool doInitialization(llvm::Module &M) override;
+    bool doFinalization(llvm::Module &M) override;
+    ProgramGraph &getPDG() { return *_PDG; }
+    // filled when -pdg-mem-report is on
+    MemoryReport &getMemReport() { return _mem_report; }
+
+  private:
+    std::unique_ptr<ProgramGraph> _owned_graph;
+    ProgramGraph *_PDG;
+    MemoryReport _mem_report;
+  };
+
+  // new pass manager counterpart of ProgramGraphWrapperPass. A fresh graph is created for
+  // every module and lives until a pass stops preserving the module analyses
+  class ProgramGraphAnalysis : public llvm::AnalysisInfoMixin<ProgramGraphAnalysis>
+  {
+  public:
+    struct Result
+    {
+      std::unique_ptr<ProgramGraph> graph;
+      std::unique_ptr<MemoryReport> mem_report;
+      // the legacy passes get these stages scheduled through addRequired, the new pass
+      // manager passes record what has already run on the graph
+      bool has_data_deps = false;
+      bool has_pdg = false;
+      bool invalidate(llvm::Module &M, const llvm::PreservedAnalyses &PA, llvm::ModuleAnalysisManager::Invalidator &inv);
+    };
+    Result run(llvm::Module &M, llvm::ModuleAnalysisManager &MAM);
+
+  private:
+    friend llvm::AnalysisInfoMixin<ProgramGraphAnalysis>;
+    static llvm::AnalysisKey Key;
+  };
+} // namespace pdg
+
+#endif
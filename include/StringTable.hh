@@ -0,0 +1,39 @@
+#ifndef STRINGTABLE_H_
+#define STRINGTABLE_H_
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include <vector>
+
+namespace pdg
+{
+  // interns the file paths and annotation strings attached to nodes, nodes only keep the
+  // 32 bit handle. Handles stay valid until the table is cleared.
+  class StringTable
+  {
+  public:
+    static constexpr unsigned NONE = 0; // "None", the annotation of unannotated nodes
+    static constexpr unsigned NOT_FOUND = 1;
+    static constexpr unsigned EMPTY = 2;
+
+    StringTable() { clear(); }
+    StringTable(const StringTable &) = delete;
+    StringTable &operator=(const StringTable &) = delete;
+    unsigned intern(llvm::StringRef str);
+    // "directory/filename" of a debug info file, computed once per DIFile
+    unsigned internFilePath(llvm::DIFile *file);
+    llvm::StringRef get(unsigned id) const { return _strings[id]; }
+    unsigned size() const { return _strings.size(); }
+    // approximate heap bytes held by the table, including the string data
+    size_t getMemoryUsage() const;
+    void clear();
+
+  private:
+    llvm::StringMap<unsigned> _string_ids;
+    std::vector<llvm::StringRef> _strings;
+    llvm::DenseMap<llvm::DIFile *, unsigned> _file_path_ids;
+  };
+} // namespace pdg
+
+#endif
@@ -5,45 +5,48 @@
 #include "PDGNode.hh"
 #include "PDGEnums.hh"
 #include "PDGUtils.hh"
-#include <set>
-#include <unordered_set>
+#include "PDGCommandLineOptions.hh"
+#include "TreeShape.hh"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include <vector>
 
 namespace pdg
 {
   class Tree;
+  class TreeNode;
+  // the children of a tree node, the folded entries of its shape slice skipped
+  using TreeNodeRange = llvm::iterator_range<llvm::filter_iterator<TreeNode *const *, bool (*)(TreeNode *)>>;
+
+  // a node of one tree instance. The layout (parent, children, depth) comes from the shared
+  // TreeShape and the addr vars and access tags live in side tables of the Tree, so a tree node
+  // only adds its tree and shape index to the graph node
   class TreeNode : public Node
   {
     public:
-      TreeNode(const TreeNode& tree_node); 
-      TreeNode(llvm::DIType *di_type, int depth, TreeNode* parent_node, Tree* tree, GraphNodeType node_type);
-      TreeNode(llvm::Function &f, llvm::DIType *di_type, int depth, TreeNode* parent_node, Tree* tree, GraphNodeType node_type);
-      int expandNode(); // build child nodes and connect with them
-      llvm::DILocalVariable *getDILocalVar() { return _di_local_var; }
-      void insertChildNode(TreeNode *new_child_node) { _children.push_back(new_child_node); }
-      void setParentTreeNode(TreeNode *parent_node) { _parent_node = parent_node; }
-      void setDILocalVariable(llvm::DILocalVariable &di_local_var) { _di_local_var = &di_local_var; }
-      void addAddrVar(llvm::Value &v) { _addr_vars.insert(&v); }
-      std::vector<TreeNode *> &getChildNodes() { return _children; }
-      std::unordered_set<llvm::Value *> &getAddrVars() { return _addr_vars; }
-      void computeDerivedAddrVarsFromParent();
-      TreeNode *getParentNode() { return _parent_node; }
+      TreeNode(const TreeNode &tree_node, Tree *tree);
+      TreeNode(GraphArena &arena, llvm::DIType *di_type, Tree *tree, unsigned shape_idx, GraphNodeType node_type);
+      TreeNode(GraphArena &arena, llvm::Function &f, llvm::DIType *di_type, Tree *tree, unsigned shape_idx, GraphNodeType node_type);
+      llvm::DILocalVariable *getDILocalVar();
+      void setDILocalVariable(llvm::DILocalVariable &di_local_var);
+      void addAddrVar(llvm::Value &v);
+      TreeNodeRange getChildNodes();
+      llvm::ArrayRef<llvm::Value *> getAddrVars();
+      TreeNode *getParentNode();
       Tree *getTree() { return _tree; }
-      int getDepth() { return _depth; }
-      void addAccessTag(AccessTag acc_tag) { _acc_tag_set.insert(acc_tag); }
-      std::set<AccessTag> &getAccessTags() { return _acc_tag_set; }
-      bool isRootNode() {return _parent_node == nullptr;}
-      int numOfChild() { return _children.size(); }
-      bool hasReadAccess() { return _acc_tag_set.find(AccessTag::DATA_READ) != _acc_tag_set.end(); }
-      bool hasWriteAccess() { return _acc_tag_set.find(AccessTag::DATA_WRITE) != _acc_tag_set.end(); }
+      unsigned getShapeIdx() const { return _shape_idx; }
+      int getDepth();
+      void addAccessTag(AccessTag acc_tag);
+      bool isRootNode() { return _shape_idx == 0; }
+      int numOfChild();
+      bool hasReadAccess();
+      bool hasWriteAccess();
+      bool isTreeNode() const override { return true; }
+      size_t getMemoryUsage() const override;
 
     private:
-      Tree *_tree;
-      TreeNode *_parent_node = nullptr;
-      int _depth;
-      llvm::DILocalVariable *_di_local_var;
-      std::vector<TreeNode *> _children;
-      std::unordered_set<llvm::Value *> _addr_vars;
-      std::set<AccessTag> _acc_tag_set;
+      Tree *_tree = nullptr;
+      unsigned _shape_idx = 0;
   };
 
   class Tree
@@ -52,21 +55,45 @@ namespace pdg
     Tree() = default;
     Tree(llvm::Value &v) { _base_val = &v; }
     Tree(const Tree &src_tree);
-    void setRootNode(TreeNode &root_node) { _root_node = &root_node; }
+    void setRootNode(TreeNode &root_node);
     void setTreeNodeType(GraphNodeType node_type) { _root_node->setNodeType(node_type); }
     TreeNode *getRootNode() const { return _root_node; }
     int size() { return _size; }
     void setSize(int size) { _size = size; }
     void increaseTreeSize() { _size++; }
     void print();
-    void build(int max_tree_depth = 5);
+    // max_tree_depth 0 grows the tree until every recursion is folded, see TreeShape
+    void build(int max_tree_depth = TREEDEPTH);
     llvm::Value *getBaseVal() { return _base_val; }
     void setBaseVal(llvm::Value &v) { _base_val = &v; }
+    llvm::DILocalVariable *getDILocalVar() { return _di_local_var; }
+    void setDILocalVar(llvm::DILocalVariable &di_local_var) { _di_local_var = &di_local_var; }
+    // the per node state below is indexed by shape entry. Until build() only the root exists
+    const TreeShape *getShape() const { return _shape; }
+    TreeNode *getNode(unsigned shape_idx) const { return _nodes[shape_idx]; }
+    TreeNodeRange getChildNodes(unsigned shape_idx) const;
+    llvm::ArrayRef<llvm::Value *> getAddrVars(unsigned shape_idx) const;
+    // only the node built last can get addr vars, the ones before it are packed already
+    void addAddrVar(unsigned shape_idx, llvm::Value &v);
+    void addAccessTag(unsigned shape_idx, AccessTag acc_tag) { _acc_tags[shape_idx] |= 1 << static_cast<unsigned>(acc_tag); }
+    bool hasAccessTag(unsigned shape_idx, AccessTag acc_tag) const { return _acc_tags[shape_idx] & (1 << static_cast<unsigned>(acc_tag)); }
+    size_t getMemoryUsage() const;
 
   private:
-    llvm::Value* _base_val;
-    TreeNode *_root_node;
-    int _size;
+    void computeDerivedAddrVars(unsigned shape_idx);
+
+    llvm::Value* _base_val = nullptr;
+    TreeNode *_root_node = nullptr;
+    llvm::DILocalVariable *_di_local_var = nullptr;
+    const TreeShape *_shape = nullptr;
+    // one entry per shape entry, nullptr for the folded ones. The children of a node are a
+    // slice of it, so getChildNodes can hand them out without a list per node
+    std::vector<TreeNode *> _nodes;
+    // addr vars of all nodes in shape order, the ones of node i start at _addr_var_offsets[i]
+    std::vector<unsigned> _addr_var_offsets;
+    std::vector<llvm::Value *> _addr_vars;
+    std::vector<uint8_t> _acc_tags; // one bit per AccessTag
+    int _size = 0;
   };
 } // namespace pdg
 
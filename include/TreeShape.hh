@@ -0,0 +1,78 @@
+#ifndef TREESHAPE_H_
+#define TREESHAPE_H_
+#include "DITypeCache.hh"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include <memory>
+#include <vector>
+
+namespace pdg
+{
+  // the layout of a parameter tree grown from one root DIType: the DIType, parent, depth and
+  // children of every tree node, in the breadth first order Tree::build creates the nodes.
+  // Immutable once built, all formal and actual trees with the same root type share it and a
+  // TreeNode is only an index into it.
+  //
+  // A struct reached again below itself (linked lists, trees) is not expanded a second time,
+  // the node pointing to it gets an edge back to the ancestor instead. Other repeated struct
+  // types are expanded at most type_budget times per tree, later occurrences stay leaves
+  class TreeShape
+  {
+  public:
+    struct ShapeNode
+    {
+      llvm::DIType *di_type;
+      int parent; // index into the shape, -1 for the root
+      // >= 0 if this entry is a folded recursion and not a node: the parent points back to the
+      // ancestor at this index
+      int fold_target;
+      int depth;
+      // the children are the consecutive entries [first_child, first_child + num_children),
+      // folded entries included
+      unsigned first_child;
+      unsigned num_children;
+    };
+
+    // max_tree_depth 0 and type_budget 0 mean no limit
+    TreeShape(DITypeCache &di_types, llvm::DIType *root_di_type, int max_tree_depth, unsigned type_budget);
+    const std::vector<ShapeNode> &getNodes() const { return _nodes; }
+    // nodes on the levels that were expanded, the size Tree::size() reports
+    int getExpandedSize() const { return _expanded_size; }
+    // tree nodes an instance gets, folded entries are edges and not counted
+    unsigned getNumNodes() const { return _nodes.size() - _num_folded; }
+    // depth of the deepest node, 0 for a root without children
+    int getMaxDepth() const { return _max_depth; }
+    // struct nodes that have children in debug info but were left as leaves by the type budget
+    unsigned getNumBudgetCut() const { return _num_budget_cut; }
+    size_t getMemoryUsage() const { return sizeof(TreeShape) + _nodes.capacity() * sizeof(ShapeNode); }
+
+  private:
+    int findFoldTarget(DITypeCache &di_types, int node_idx, llvm::DIType *child_di_type) const;
+
+    std::vector<ShapeNode> _nodes;
+    int _expanded_size = 0;
+    int _max_depth = 0;
+    unsigned _num_folded = 0;
+    unsigned _num_budget_cut = 0;
+  };
+
+  // one shape per (root DIType, depth), owned by the graph arena. The type budget is the
+  // -pdg-tree-type-budget option
+  class TreeShapeCache
+  {
+  public:
+    explicit TreeShapeCache(DITypeCache &di_types) : _di_types(di_types) {}
+    TreeShapeCache(const TreeShapeCache &) = delete;
+    TreeShapeCache &operator=(const TreeShapeCache &) = delete;
+    const TreeShape &getShape(llvm::DIType *root_di_type, int max_tree_depth);
+    size_t size() const { return _shapes.size(); }
+    size_t getMemoryUsage() const;
+    void clear() { _shapes.clear(); }
+
+  private:
+    DITypeCache &_di_types;
+    llvm::DenseMap<std::pair<llvm::DIType *, int>, std::unique_ptr<TreeShape>> _shapes;
+  };
+} // namespace pdg
+
+#endif
@@ -5,6 +5,7 @@
 #include "PDGEnums.hh"
 #include "FunctionWrapper.hh"
 
+#include <deque>
 #include <fstream>
 #include <functional>
 #include <optional>
@@ -72,7 +73,7 @@ namespace pdg
   template<typename A, typename B>
   struct RangesAndIds {
     std::map<A, std::pair<size_t, size_t>> ranges;
-    std::map<unsigned int, size_t> ids;
+    std::vector<size_t> ids; // indexed by node / edge id
     std::vector<B> ordered;
   };
 
@@ -83,16 +84,18 @@ namespace pdg
   { 
   private:
     template<typename A, typename B>
-    static RangesAndIds<A, B> toRangesAndIds(std::map<A, std::vector<B>> groupedByA, std::function<unsigned int(B)> getId); 
-    static std::map<unsigned int, unsigned int> hasFn(pdg::ProgramGraph &PDG);
+    static RangesAndIds<A, B> toRangesAndIds(std::map<A, std::vector<B>> groupedByA, std::function<unsigned int(B)> getId, size_t numIds); 
+    static std::vector<std::optional<unsigned int>> hasFn(pdg::ProgramGraph &PDG);
     static std::optional<MznNodeType> nodeMznType(pdg::GraphNodeType nodeType);
     static std::optional<MznEdgeType> edgeMznType(pdg::EdgeType nodeType);
     static std::string mznNodeName(MznNodeType nodeType);
     static std::string mznEdgeName(MznEdgeType edgeType);
     static std::map<pdg::GraphNodeType, std::vector<Node *>> nodesByNodeType(pdg::ProgramGraph &PDG);
-    static std::map<pdg::EdgeType, std::vector<Edge *>> edgesByEdgeType(pdg::ProgramGraph &PDG);
+    // the edges of the snapshot's range records get temporary objects in range_edges, with ids
+    // after the graph's own edge ids
+    static std::map<pdg::EdgeType, std::vector<Edge *>> edgesByEdgeType(pdg::ProgramGraph &PDG, std::deque<Edge> &range_edges);
     static size_t maxFnParams(pdg::ProgramGraph &PDG);
-    static std::map<unsigned int, bool> fnResultUsed(EdgeRangesAndIds ids);
+    static std::vector<bool> fnResultUsed(EdgeRangesAndIds ids, size_t numNodeIds);
 
     template<typename A>
     static std::optional<std::pair<int, int>> calculateCollatedRange(std::map<A, std::pair<size_t, size_t>> ranges, A start, A end);
@@ -102,15 +105,15 @@ namespace pdg
 
     static void exportMznNodes(std::ofstream &mzn, NodeRangesAndIds nodes);
     static void exportMznEdges(std::ofstream &mzn, EdgeRangesAndIds edges);
-    static void exportMznHasFn(std::ofstream &mzn, NodeRangesAndIds nodes, std::map<unsigned int, unsigned int> hasFn);
+    static void exportMznHasFn(std::ofstream &mzn, NodeRangesAndIds nodes, std::vector<std::optional<unsigned int>> hasFn);
     static void exportMznSrcDst(std::ofstream &mzn, NodeRangesAndIds nodes, EdgeRangesAndIds edges);
     static void exportMznParamIdx(std::ofstream &mzn, NodeRangesAndIds nodes);
     static void exportMznUserAnnotated(std::ofstream &mzn, NodeRangesAndIds nodes);
     static void exportMznConstraints(std::ofstream &mzn, NodeRangesAndIds nodes);
-    static void exportMzn(std::string filename, NodeRangesAndIds nodes, EdgeRangesAndIds edges, std::map<unsigned int, unsigned int> hasFn, size_t maxFnParams);
-    static void exportDebug(std::string filename, NodeRangesAndIds nodes, EdgeRangesAndIds edges, std::map<unsigned int, unsigned int> hasFn);
-    static void exportNodeToLLID(std::string filename, NodeRangesAndIds nodes, std::map<unsigned int, unsigned int> hasFn);
-    static void exportOneway(std::string filename, NodeRangesAndIds nodes, std::map<unsigned int, bool> fnResultUsed);
+    static void exportMzn(std::string filename, NodeRangesAndIds nodes, EdgeRangesAndIds edges, std::vector<std::optional<unsigned int>> hasFn, size_t maxFnParams);
+    static void exportDebug(std::string filename, NodeRangesAndIds nodes, EdgeRangesAndIds edges, std::vector<std::optional<unsigned int>> hasFn);
+    static void exportNodeToLLID(std::string filename, NodeRangesAndIds nodes, std::vector<std::optional<unsigned int>> hasFn);
+    static void exportOneway(std::string filename, NodeRangesAndIds nodes, std::vector<bool> fnResultUsed);
     static void exportFnArgs(std::string filename, NodeRangesAndIds nodes);
     static void exportLineNumbers(std::string filename, NodeRangesAndIds nodes);
 
@@ -120,6 +123,15 @@ namespace pdg
     MiniZincPrinter() : llvm::ModulePass(ID) {};
     bool runOnModule(llvm::Module &M) override;
     void getAnalysisUsage(llvm::AnalysisUsage &AU) const override;
+    // write pdg_data.csv and/or pdg_instance.mzn with its side files for a finished graph
+    static void exportGraph(ProgramGraph &g, bool export_mzn = true, bool export_csv = true);
+  };
+
+  // -passes=minizinc, builds the pdg first unless it already ran on this module
+  class MiniZincPrinterPass : public llvm::PassInfoMixin<MiniZincPrinterPass>
+  {
+  public:
+    llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &MAM);
   };
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,456 @@
+#include "AndersenAA.hh"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/MemoryBuiltins.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+
+using namespace llvm;
+
+void pdg::AndersenAA::clear()
+{
+  _pts.clear();
+  _copy_succs.clear();
+  _copy_edges.clear();
+  _loads.clear();
+  _stores.clear();
+  _ind_calls.clear();
+  _bound_calls.clear();
+  _value_nodes.clear();
+  _object_nodes.clear();
+  _ret_nodes.clear();
+  _object_sites.clear();
+  _escaped.clear();
+  _unknown = NO_NODE;
+  _worklist.clear();
+  _queued.clear();
+  _solving = false;
+}
+
+unsigned pdg::AndersenAA::createNode()
+{
+  unsigned id = _pts.size();
+  _pts.emplace_back();
+  _copy_succs.emplace_back();
+  _loads.emplace_back();
+  _stores.emplace_back();
+  _ind_calls.emplace_back();
+  _object_sites.push_back(nullptr);
+  _queued.push_back(false);
+  return id;
+}
+
+unsigned pdg::AndersenAA::getOrCreateValueNode(const Value *v)
+{
+  auto iter = _value_nodes.find(v);
+  if (iter != _value_nodes.end())
+    return iter->second;
+  unsigned id = createNode();
+  _value_nodes[v] = id;
+  return id;
+}
+
+unsigned pdg::AndersenAA::getOrCreateObjectNode(const Value *alloc_site)
+{
+  auto iter = _object_nodes.find(alloc_site);
+  if (iter != _object_nodes.end())
+    return iter->second;
+  unsigned id = createNode();
+  _object_nodes[alloc_site] = id;
+  _object_sites[id] = alloc_site;
+  return id;
+}
+
+unsigned pdg::AndersenAA::getOrCreateRetNode(const Function *f)
+{
+  auto iter = _ret_nodes.find(f);
+  if (iter != _ret_nodes.end())
+    return iter->second;
+  unsigned id = createNode();
+  _ret_nodes[f] = id;
+  return id;
+}
+
+unsigned pdg::AndersenAA::getPointerNode(const Value *v)
+{
+  if (auto ce = dyn_cast<ConstantExpr>(v))
+  {
+    if (ce->getOpcode() == Instruction::BitCast || ce->getOpcode() == Instruction::AddrSpaceCast || ce->getOpcode() == Instruction::GetElementPtr)
+      return getPointerNode(ce->getOperand(0));
+    // int to ptr and other pointer valued expressions
+    return ce->getType()->isPointerTy() ? _unknown : NO_NODE;
+  }
+  // null, undef and aggregates do not point anywhere we track
+  if (isa<Constant>(v) && !isa<GlobalValue>(v))
+    return NO_NODE;
+  if (isa<InlineAsm>(v) || isa<MetadataAsValue>(v))
+    return NO_NODE;
+  return getOrCreateValueNode(v);
+}
+
+unsigned pdg::AndersenAA::lookupPointerNode(const Value *v) const
+{
+  if (auto ce = dyn_cast<ConstantExpr>(v))
+  {
+    if (ce->getOpcode() == Instruction::BitCast || ce->getOpcode() == Instruction::AddrSpaceCast || ce->getOpcode() == Instruction::GetElementPtr)
+      return lookupPointerNode(ce->getOperand(0));
+    return ce->getType()->isPointerTy() ? _unknown : NO_NODE;
+  }
+  auto iter = _value_nodes.find(v);
+  if (iter == _value_nodes.end())
+    return NO_NODE;
+  return iter->second;
+}
+
+void pdg::AndersenAA::push(unsigned n)
+{
+  if (_queued[n])
+    return;
+  _queued[n] = true;
+  _worklist.push_back(n);
+}
+
+void pdg::AndersenAA::addAddressOf(unsigned dst, unsigned obj)
+{
+  if (_pts[dst].test_and_set(obj) && _solving)
+    push(dst);
+}
+
+bool pdg::AndersenAA::addCopy(unsigned src, unsigned dst)
+{
+  if (src == dst || !_copy_edges.insert(std::make_pair(src, dst)).second)
+    return false;
+  _copy_succs[src].push_back(dst);
+  // edges found while solving have to catch up with what src already points to
+  if (_solving && (_pts[dst] |= _pts[src]))
+    push(dst);
+  return true;
+}
+
+void pdg::AndersenAA::addLoad(unsigned dst, unsigned src_ptr)
+{
+  _loads[src_ptr].push_back(dst);
+}
+
+void pdg::AndersenAA::addStore(unsigned dst_ptr, unsigned src)
+{
+  _stores[dst_ptr].push_back(src);
+}
+
+void pdg::AndersenAA::addGlobalInitializer(unsigned obj, const Constant *init)
+{
+  if (init->getType()->isPointerTy())
+  {
+    unsigned n = getPointerNode(init);
+    if (n != NO_NODE)
+      addCopy(n, obj);
+    return;
+  }
+  if (isa<ConstantAggregate>(init))
+  {
+    for (auto &op : init->operands())
+      addGlobalInitializer(obj, cast<Constant>(op));
+  }
+}
+
+void pdg::AndersenAA::addEscape(unsigned n)
+{
+  addCopy(n, _unknown);
+}
+
+// external code can read the pointers held by an escaped object and store any escaped
+// pointer into it. An escaped function can be called with escaped pointers and hands its
+// return value back to external code.
+void pdg::AndersenAA::escapeObject(unsigned obj)
+{
+  addCopy(obj, _unknown);
+  addCopy(_unknown, obj);
+  auto f = dyn_cast_or_null<Function>(_object_sites[obj]);
+  if (f == nullptr || f->isDeclaration())
+    return;
+  for (auto &formal_arg : f->args())
+  {
+    if (formal_arg.getType()->isPointerTy())
+      addCopy(_unknown, getOrCreateValueNode(&formal_arg));
+  }
+  if (f->getReturnType()->isPointerTy())
+    addCopy(getOrCreateRetNode(f), _unknown);
+}
+
+void pdg::AndersenAA::addInstructionConstraints(Instruction &inst)
+{
+  bool is_ptr = inst.getType()->isPointerTy();
+  if (auto ai = dyn_cast<AllocaInst>(&inst))
+  {
+    addAddressOf(getOrCreateValueNode(ai), getOrCreateObjectNode(ai));
+  }
+  else if (auto li = dyn_cast<LoadInst>(&inst))
+  {
+    unsigned src_ptr = getPointerNode(li->getPointerOperand());
+    if (is_ptr && src_ptr != NO_NODE)
+      addLoad(getOrCreateValueNode(li), src_ptr);
+  }
+  else if (auto si = dyn_cast<StoreInst>(&inst))
+  {
+    if (!si->getValueOperand()->getType()->isPointerTy())
+      return;
+    unsigned dst_ptr = getPointerNode(si->getPointerOperand());
+    unsigned src = getPointerNode(si->getValueOperand());
+    if (dst_ptr != NO_NODE && src != NO_NODE)
+      addStore(dst_ptr, src);
+  }
+  else if (isa<BitCastInst>(&inst) || isa<AddrSpaceCastInst>(&inst) || isa<GetElementPtrInst>(&inst))
+  {
+    unsigned src = getPointerNode(inst.getOperand(0));
+    if (is_ptr && src != NO_NODE)
+      addCopy(src, getOrCreateValueNode(&inst));
+  }
+  else if (auto phi = dyn_cast<PHINode>(&inst))
+  {
+    if (!is_ptr)
+      return;
+    for (auto &incoming : phi->incoming_values())
+    {
+      unsigned src = getPointerNode(incoming);
+      if (src != NO_NODE)
+        addCopy(src, getOrCreateValueNode(phi));
+    }
+  }
+  else if (auto sel = dyn_cast<SelectInst>(&inst))
+  {
+    if (!is_ptr)
+      return;
+    for (auto op : {sel->getTrueValue(), sel->getFalseValue()})
+    {
+      unsigned src = getPointerNode(op);
+      if (src != NO_NODE)
+        addCopy(src, getOrCreateValueNode(sel));
+    }
+  }
+  else if (auto ri = dyn_cast<ReturnInst>(&inst))
+  {
+    auto ret_val = ri->getReturnValue();
+    if (ret_val == nullptr || !ret_val->getType()->isPointerTy())
+      return;
+    unsigned src = getPointerNode(ret_val);
+    if (src != NO_NODE)
+      addCopy(src, getOrCreateRetNode(ri->getFunction()));
+  }
+  else if (auto cb = dyn_cast<CallBase>(&inst))
+  {
+    addCallConstraints(*cb);
+  }
+  else if (is_ptr)
+  {
+    // int to ptr, extractvalue, va_arg and friends
+    addAddressOf(getOrCreateValueNode(&inst), _unknown);
+  }
+}
+
+void pdg::AndersenAA::addCallConstraints(CallBase &cb)
+{
+  // copy the pointers held by the source buffer into the destination buffer
+  if (auto mti = dyn_cast<MemTransferInst>(&cb))
+  {
+    unsigned dst_ptr = getPointerNode(mti->getRawDest());
+    unsigned src_ptr = getPointerNode(mti->getRawSource());
+    if (dst_ptr == NO_NODE || src_ptr == NO_NODE)
+      return;
+    unsigned tmp = createNode();
+    addLoad(tmp, src_ptr);
+    addStore(dst_ptr, tmp);
+    return;
+  }
+  // pointer returning intrinsics (ptr.annotation, launder.invariant.group, ...) return their
+  // first argument
+  if (isa<IntrinsicInst>(&cb))
+  {
+    if (!cb.getType()->isPointerTy() || cb.arg_size() == 0 || !cb.getArgOperand(0)->getType()->isPointerTy())
+      return;
+    unsigned src = getPointerNode(cb.getArgOperand(0));
+    if (src != NO_NODE)
+      addCopy(src, getOrCreateValueNode(&cb));
+    return;
+  }
+
+  auto called_val = cb.getCalledOperand()->stripPointerCasts();
+  if (auto callee = dyn_cast<Function>(called_val))
+  {
+    bindCall(cb, *callee);
+    return;
+  }
+  if (isa<InlineAsm>(called_val))
+  {
+    bindExternalCall(cb);
+    return;
+  }
+  unsigned callee_node = getPointerNode(called_val);
+  if (callee_node != NO_NODE)
+    _ind_calls[callee_node].push_back(&cb);
+}
+
+void pdg::AndersenAA::bindCall(CallBase &cb, const Function &callee)
+{
+  if (callee.isDeclaration())
+  {
+    bindExternalCall(cb);
+    return;
+  }
+  if (!_bound_calls.insert(std::make_pair(&cb, &callee)).second)
+    return;
+
+  unsigned num_args = std::min<unsigned>(cb.arg_size(), callee.arg_size());
+  for (unsigned i = 0; i < num_args; i++)
+  {
+    auto formal_arg = callee.getArg(i);
+    if (!formal_arg->getType()->isPointerTy())
+      continue;
+    unsigned actual = getPointerNode(cb.getArgOperand(i));
+    if (actual != NO_NODE)
+      addCopy(actual, getOrCreateValueNode(formal_arg));
+  }
+  if (cb.getType()->isPointerTy())
+    addCopy(getOrCreateRetNode(&callee), getOrCreateValueNode(&cb));
+}
+
+void pdg::AndersenAA::bindExternalCall(CallBase &cb)
+{
+  if (!_bound_calls.insert(std::make_pair(&cb, nullptr)).second)
+    return;
+  // every call to malloc, calloc, strdup and the like allocates a fresh object
+  if (isAllocLikeFn(&cb, _tli))
+  {
+    addAddressOf(getOrCreateValueNode(&cb), getOrCreateObjectNode(&cb));
+    return;
+  }
+  // anything else may keep its pointer arguments and return one of them (strchr, realloc,
+  // fgets) or memory the module never sees
+  for (auto &arg : cb.args())
+  {
+    if (!arg->getType()->isPointerTy())
+      continue;
+    unsigned n = getPointerNode(arg);
+    if (n != NO_NODE)
+      addEscape(n);
+  }
+  if (cb.getType()->isPointerTy())
+    addCopy(_unknown, getOrCreateValueNode(&cb));
+}
+
+void pdg::AndersenAA::solve()
+{
+  _solving = true;
+  for (unsigned n = 0; n < _pts.size(); n++)
+  {
+    if (!_pts[n].empty())
+      push(n);
+  }
+
+  while (!_worklist.empty())
+  {
+    unsigned n = _worklist.back();
+    _worklist.pop_back();
+    _queued[n] = false;
+    // copy, the loops below may grow the node vectors or add to _pts[n] itself
+    SparseBitVector<> pts = _pts[n];
+
+    for (unsigned i = 0; i < _loads[n].size(); i++)
+    {
+      unsigned dst = _loads[n][i];
+      for (unsigned obj : pts)
+        addCopy(obj, dst);
+    }
+    for (unsigned i = 0; i < _stores[n].size(); i++)
+    {
+      unsigned src = _stores[n][i];
+      for (unsigned obj : pts)
+        addCopy(src, obj);
+    }
+    for (unsigned i = 0; i < _ind_calls[n].size(); i++)
+    {
+      CallBase *cb = _ind_calls[n][i];
+      for (unsigned obj : pts)
+      {
+        if (obj == _unknown)
+          bindExternalCall(*cb);
+        else if (auto callee = dyn_cast_or_null<Function>(_object_sites[obj]))
+          bindCall(*cb, *callee);
+      }
+    }
+    if (n == _unknown)
+    {
+      SparseBitVector<> newly_escaped;
+      newly_escaped.intersectWithComplement(pts, _escaped);
+      _escaped |= newly_escaped;
+      for (unsigned obj : newly_escaped)
+        escapeObject(obj);
+    }
+    for (unsigned i = 0; i < _copy_succs[n].size(); i++)
+    {
+      unsigned succ = _copy_succs[n][i];
+      if (_pts[succ] |= pts)
+        push(succ);
+    }
+  }
+  _solving = false;
+}
+
+void pdg::AndersenAA::analyze(Module &M)
+{
+  clear();
+  TargetLibraryInfoImpl tlii(Triple(M.getTargetTriple()));
+  TargetLibraryInfo tli(tlii);
+  _tli = &tli;
+  _unknown = createNode();
+  addAddressOf(_unknown, _unknown);
+  for (auto &global_var : M.globals())
+  {
+    addAddressOf(getOrCreateValueNode(&global_var), getOrCreateObjectNode(&global_var));
+    // defined elsewhere, stdin, errno and the like
+    if (global_var.isDeclaration())
+      addEscape(getOrCreateValueNode(&global_var));
+  }
+  for (auto &F : M)
+    addAddressOf(getOrCreateValueNode(&F), getOrCreateObjectNode(&F));
+  for (auto &global_alias : M.aliases())
+  {
+    unsigned aliasee = getPointerNode(global_alias.getAliasee());
+    if (aliasee != NO_NODE)
+      addCopy(aliasee, getOrCreateValueNode(&global_alias));
+  }
+  for (auto &global_var : M.globals())
+  {
+    if (global_var.hasInitializer())
+      addGlobalInitializer(getOrCreateObjectNode(&global_var), global_var.getInitializer());
+  }
+
+  for (auto &F : M)
+  {
+    if (F.isDeclaration())
+      continue;
+    for (auto inst_iter = inst_begin(F); inst_iter != inst_end(F); inst_iter++)
+      addInstructionConstraints(*inst_iter);
+  }
+  // the program entry is called from outside with pointers the module never sees
+  if (auto main_func = M.getFunction("main"))
+    addEscape(getOrCreateValueNode(main_func));
+  solve();
+  _tli = nullptr;
+}
+
+const SparseBitVector<> *pdg::AndersenAA::getPointsToSet(const Value *v) const
+{
+  unsigned n = lookupPointerNode(v);
+  if (n == NO_NODE || _pts[n].empty())
+    return nullptr;
+  return &_pts[n];
+}
+
+AliasResult pdg::AndersenAA::alias(const Value *v1, const Value *v2) const
+{
+  if (v1 == v2)
+    return AliasResult::MustAlias;
+  auto pts1 = getPointsToSet(v1);
+  auto pts2 = getPointsToSet(v2);
+  if (pts1 == nullptr || pts2 == nullptr || pts1->test(_unknown) || pts2->test(_unknown))
+    return AliasResult::MayAlias;
+  return pts1->intersects(*pts2) ? AliasResult::MayAlias : AliasResult::NoAlias;
+}
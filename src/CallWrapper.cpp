@@ -2,9 +2,16 @@
 
 using namespace llvm;
 
+size_t pdg::CallWrapper::getMemoryUsage() const
+{
+  return sizeof(CallWrapper) + _arg_list.capacity() * sizeof(Value *) +
+         pdgutils::getMapVectorMemoryUsage(_arg_actual_in_tree_map) + pdgutils::getMapVectorMemoryUsage(_arg_actual_out_tree_map);
+}
+
 void pdg::CallWrapper::buildActualTreeForArgs(FunctionWrapper &callee_fw)
 {
   Function* called_func = callee_fw.getFunc();
+  GraphArena &arena = callee_fw.getArena();
   // we don't handle varidic function at the moment
   if (called_func->isVarArg())
     return;
@@ -21,7 +28,7 @@ void pdg::CallWrapper::buildActualTreeForArgs(FunctionWrapper &callee_fw)
     if (!arg_formal_in_tree) // in some case, not each parameter has tree, for example, a function with structure parameter
       break;
     // build actual in tree, copying the formal_in tree structure at the moment
-    Tree* arg_actual_in_tree = new Tree(*arg_formal_in_tree);
+    Tree* arg_actual_in_tree = arena.create<Tree>(*arg_formal_in_tree);
 
     // arg_actual_in_tree->getRootNode()->setFunc(*_call_inst->getFunction());
     arg_actual_in_tree->setBaseVal(**actual_arg_iter);
@@ -31,16 +38,16 @@ void pdg::CallWrapper::buildActualTreeForArgs(FunctionWrapper &callee_fw)
     actual_in_root_node->setParamIdx(arg->getArgNo());
     actual_in_root_node->addAddrVar(**actual_arg_iter);
     
-    arg_actual_in_tree->build();
+    arg_actual_in_tree->build(callee_fw.getTreeDepth());
     _arg_actual_in_tree_map.insert(std::make_pair(*actual_arg_iter, arg_actual_in_tree));
     // build actual out tree
-    Tree* arg_actual_out_tree = new Tree(*arg_formal_in_tree);
+    Tree* arg_actual_out_tree = arena.create<Tree>(*arg_formal_in_tree);
     arg_actual_out_tree->setBaseVal(**actual_arg_iter);
     arg_actual_out_tree->setTreeNodeType(GraphNodeType::PARAM_ACTUALOUT);
     TreeNode* actual_out_root_node = arg_actual_out_tree->getRootNode();
     actual_out_root_node->addAddrVar(**actual_arg_iter);
     actual_out_root_node->setParamIdx(arg->getArgNo());
-    arg_actual_out_tree->build();
+    arg_actual_out_tree->build(callee_fw.getTreeDepth());
     _arg_actual_out_tree_map.insert(std::make_pair(*actual_arg_iter, arg_actual_out_tree));
     actual_arg_iter++;
     formal_arg_iter++;
@@ -52,20 +59,21 @@ void pdg::CallWrapper::buildActualTreesForRetVal(FunctionWrapper &callee_fw)
   Tree *ret_formal_in_tree = callee_fw.getRetFormalInTree();
   if (!ret_formal_in_tree)
     return;
+  GraphArena &arena = callee_fw.getArena();
   // build actual in tree, copying the formal_in tree structure at the moment
-  Tree *ret_actual_in_tree = new Tree(*ret_formal_in_tree);
+  Tree *ret_actual_in_tree = arena.create<Tree>(*ret_formal_in_tree);
   ret_actual_in_tree->setTreeNodeType(GraphNodeType::PARAM_ACTUALIN);
   TreeNode *ret_actual_in_root_node = ret_actual_in_tree->getRootNode();
   ret_actual_in_root_node->addAddrVar(*_call_inst);
-  ret_actual_in_tree->build();
+  ret_actual_in_tree->build(callee_fw.getTreeDepth());
   _ret_val_actual_in_tree = ret_actual_in_tree;
 
   // build actual out tree
-  Tree *ret_actual_out_tree = new Tree(*ret_formal_in_tree);
+  Tree *ret_actual_out_tree = arena.create<Tree>(*ret_formal_in_tree);
   ret_actual_out_tree->setTreeNodeType(GraphNodeType::PARAM_ACTUALOUT);
   TreeNode *ret_actual_out_root_node = ret_actual_out_tree->getRootNode();
   ret_actual_out_root_node->addAddrVar(*_call_inst);
-  ret_actual_out_tree->build();
+  ret_actual_out_tree->build(callee_fw.getTreeDepth());
   _ret_val_actual_out_tree = ret_actual_out_tree;
 }
 
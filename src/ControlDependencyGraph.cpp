@@ -5,28 +5,36 @@ char pdg::ControlDependencyGraph::ID = 0;
 using namespace llvm;
 bool pdg::ControlDependencyGraph::runOnFunction(Function &F)
 {
-  _PDT = &getAnalysis<PostDominatorTreeWrapperPass>().getPostDomTree();
-  addControlDepFromEntryNodeToInsts(F);
-  addControlDepFromDominatedBlockToDominator(F);
+  auto &g = getAnalysis<ProgramGraphWrapperPass>().getPDG();
+  if (!g.isBuild())
+  {
+    g.build(*F.getParent());
+    g.bindDITypeToNodes(*F.getParent());
+  }
+  computeControlDependencies(F, g, getAnalysis<PostDominatorTreeWrapperPass>().getPostDomTree());
   return false;
 }
 
+void pdg::ControlDependencyGraph::computeControlDependencies(Function &F, ProgramGraph &g, PostDominatorTree &PDT)
+{
+  // not built by -pdg-demand
+  if (!g.hasFuncWrapper(F))
+    return;
+  _PDG = &g;
+  _PDT = &PDT;
+  addControlDepFromEntryNodeToInsts(F);
+  addControlDepFromPostDomFrontiers(F);
+}
+
 void pdg::ControlDependencyGraph::addControlDepFromNodeToBB(Node &n, BasicBlock &BB, EdgeType edge_type)
 {
-  ProgramGraph &g = ProgramGraph::getInstance();
-  for (auto &inst : BB)
-  {
-    Node* inst_node = g.getNode(inst);
-    // TODO: a special case when gep is used as a operand in load. Fix later
-    if (inst_node != nullptr)
-      n.addNeighbor(*inst_node, edge_type);
-    // assert(inst_node != nullptr && "cannot find node for inst\n");
-  }
+  // recorded per block, the graph expands it to the instructions of BB when edges are needed
+  _PDG->addBlockControlDep(n, BB, edge_type);
 }
 
 void pdg::ControlDependencyGraph::addControlDepFromEntryNodeToInsts(Function &F)
 {
-  ProgramGraph &g = ProgramGraph::getInstance();
+  ProgramGraph &g = *_PDG;
   FunctionWrapper* func_w = g.getFuncWrapperMap()[&F];
   for (auto &BB : F)
   {
@@ -34,47 +42,96 @@ void pdg::ControlDependencyGraph::addControlDepFromEntryNodeToInsts(Function &F)
   }
 }
 
-void pdg::ControlDependencyGraph::addControlDepFromDominatedBlockToDominator(Function &F)
+void pdg::ControlDependencyGraph::computePostDomFrontiers(Function &F, BlockListMap &pdf)
 {
-  ProgramGraph &g = ProgramGraph::getInstance();
-  for (auto &BB : F)
+  // children are visited before their parents, so their frontiers are complete when the
+  // parent pulls them up
+  for (auto *pdt_node : post_order(_PDT->getRootNode()))
   {
-    for (auto succ_iter = succ_begin(&BB); succ_iter != succ_end(&BB); succ_iter++)
+    BasicBlock *bb = pdt_node->getBlock();
+    // virtual root that joins the exit blocks
+    if (bb == nullptr)
+      continue;
+    auto &frontier = pdf[bb];
+    SmallPtrSet<BasicBlock *, 8> seen;
+    // local part: predecessors that can branch around bb
+    for (BasicBlock *pred : predecessors(bb))
+    {
+      auto *pred_node = _PDT->getNode(pred);
+      if (pred_node != nullptr && pred_node->getIDom() != pdt_node && seen.insert(pred).second)
+        frontier.push_back(pred);
+    }
+    // up part: frontier blocks of the children that bb does not immediately post dominate
+    for (auto *child : pdt_node->children())
     {
-      BasicBlock *succ_bb = *succ_iter;
-      if (&BB == &*succ_bb || !_PDT->dominates(&*succ_bb, &BB))
+      auto iter = pdf.find(child->getBlock());
+      if (iter == pdf.end())
+        continue;
+      for (BasicBlock *frontier_bb : iter->second)
       {
-        // get terminator and connect with the dependent block
-        Instruction *terminator = BB.getTerminator();
-        if (BranchInst *bi = dyn_cast<BranchInst>(terminator))
-        {
-          if (!bi->isConditional() || !bi->getCondition())
-            break;
-          // Node *cond_node = g.getNode(*bi->getCondition());
-          // if (!cond_node)
-          //   break;
-          Node *branch_node = g.getNode(*bi);
-          if (branch_node == nullptr)
-            break;
-          BasicBlock *nearestCommonDominator = _PDT->findNearestCommonDominator(&BB, succ_bb);
-          if (nearestCommonDominator == &BB)
-            addControlDepFromNodeToBB(*branch_node, *succ_bb, EdgeType::CONTROLDEP_BR);
-
-          for (auto *cur = _PDT->getNode(&*succ_bb); cur != _PDT->getNode(nearestCommonDominator); cur = cur->getIDom())
-          {
-            addControlDepFromNodeToBB(*branch_node, *cur->getBlock(), EdgeType::CONTROLDEP_BR);
-          }
-        }
+        if (_PDT->getNode(frontier_bb)->getIDom() != pdt_node && seen.insert(frontier_bb).second)
+          frontier.push_back(frontier_bb);
       }
     }
   }
 }
 
+void pdg::ControlDependencyGraph::addControlDepFromPostDomFrontiers(Function &F)
+{
+  ProgramGraph &g = *_PDG;
+  BlockListMap pdf;
+  computePostDomFrontiers(F, pdf);
+  // a block is control dependent on the terminator of every block in its frontier. Walking F
+  // in layout order keeps the dependent blocks of each terminator in layout order
+  BlockListMap dependent_blocks;
+  for (auto &BB : F)
+  {
+    auto iter = pdf.find(&BB);
+    if (iter == pdf.end())
+      continue;
+    for (BasicBlock *controller : iter->second)
+      dependent_blocks[controller].push_back(&BB);
+  }
+
+  for (auto &BB : F)
+  {
+    auto iter = dependent_blocks.find(&BB);
+    if (iter == dependent_blocks.end())
+      continue;
+    // any terminator with more than one successor: br, switch, indirectbr, invoke ...
+    Node *terminator_node = g.getNode(*BB.getTerminator());
+    if (terminator_node == nullptr)
+      continue;
+    for (BasicBlock *dep_bb : iter->second)
+      addControlDepFromNodeToBB(*terminator_node, *dep_bb, EdgeType::CONTROLDEP_BR);
+  }
+}
+
 void pdg::ControlDependencyGraph::getAnalysisUsage(AnalysisUsage &AU) const
 {
+  AU.addRequired<ProgramGraphWrapperPass>();
   AU.addRequired<PostDominatorTreeWrapperPass>();
   AU.setPreservesAll();
 }
 
+PreservedAnalyses pdg::ControlDependencyGraphPass::run(Module &M, ModuleAnalysisManager &MAM)
+{
+  auto &g = *MAM.getResult<ProgramGraphAnalysis>(M).graph;
+  if (!g.isBuild())
+  {
+    g.build(M);
+    g.bindDITypeToNodes(M);
+  }
+  auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+  ControlDependencyGraph cdg;
+  for (auto &F : M)
+  {
+    if (F.isDeclaration() || !g.hasFuncWrapper(F))
+      continue;
+    cdg.computeControlDependencies(F, g, FAM.getResult<PostDominatorTreeAnalysis>(F));
+  }
+  return PreservedAnalyses::all();
+}
+
 static RegisterPass<pdg::ControlDependencyGraph>
     CDG("cdg", "Control Dependency Graph Construction", false, true);
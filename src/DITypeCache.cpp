@@ -0,0 +1,112 @@
+#include "DITypeCache.hh"
+#include "DebugInfoUtils.hh"
+#include "PDGUtils.hh"
+
+using namespace llvm;
+
+DIType *pdg::DITypeCache::getStrippedType(DIType *dt)
+{
+  if (dt == nullptr)
+    return nullptr;
+  auto iter = _stripped_types.find(dt);
+  if (iter != _stripped_types.end())
+    return iter->second;
+  DIType *stripped_dt = dbgutils::stripAttributes(*dt);
+  _stripped_types.insert(std::make_pair(dt, stripped_dt));
+  return stripped_dt;
+}
+
+DIType *pdg::DITypeCache::getCanonicalType(DIType *dt)
+{
+  DIType *stripped_dt = getStrippedType(dt);
+  if (stripped_dt == nullptr)
+    return nullptr;
+  if (stripped_dt->getTag() != dwarf::DW_TAG_member)
+    return stripped_dt;
+  return getStrippedType(dbgutils::stripMemberTag(*stripped_dt));
+}
+
+DIType *pdg::DITypeCache::getLowestType(DIType *dt)
+{
+  if (dt == nullptr)
+    return nullptr;
+  auto iter = _lowest_types.find(dt);
+  if (iter != _lowest_types.end())
+    return iter->second;
+  DIType *lowest_dt = dbgutils::getLowestDIType(*dt);
+  _lowest_types.insert(std::make_pair(dt, lowest_dt));
+  return lowest_dt;
+}
+
+const std::vector<DIType *> &pdg::DITypeCache::getFields(DIType *dt)
+{
+  auto result = _fields.try_emplace(dt);
+  auto &fields = result.first->second;
+  if (!result.second || dt == nullptr || !dbgutils::isStructType(*dt))
+    return fields;
+  // TODO: should change to aggregate type later
+  for (auto element : cast<DICompositeType>(dt)->getElements())
+    fields.push_back(dyn_cast<DIType>(element));
+  return fields;
+}
+
+const std::vector<DIType *> &pdg::DITypeCache::getChildTypes(DIType *dt)
+{
+  auto result = _child_types.try_emplace(dt);
+  auto &child_types = result.first->second;
+  if (!result.second)
+    return child_types;
+  DIType *stripped_dt = getStrippedType(dt);
+  if (stripped_dt == nullptr)
+    return child_types;
+  stripped_dt = dbgutils::stripMemberTag(*stripped_dt);
+  if (stripped_dt == nullptr)
+    return child_types;
+  if (dbgutils::isPointerType(*stripped_dt))
+    child_types.push_back(getLowestType(stripped_dt));
+  else if (dbgutils::isStructType(*stripped_dt))
+    child_types = getFields(stripped_dt);
+  return child_types;
+}
+
+const std::string &pdg::DITypeCache::getTypeName(DIType *dt)
+{
+  auto result = _type_names.try_emplace(dt);
+  if (result.second && dt != nullptr)
+    result.first->second = dbgutils::getSourceLevelTypeName(*dt);
+  return result.first->second;
+}
+
+const std::string &pdg::DITypeCache::getVariableName(DIType *dt)
+{
+  auto result = _variable_names.try_emplace(dt);
+  if (result.second && dt != nullptr)
+    result.first->second = dbgutils::getSourceLevelVariableName(*dt);
+  return result.first->second;
+}
+
+size_t pdg::DITypeCache::getMemoryUsage() const
+{
+  size_t bytes = _stripped_types.getMemorySize() + _lowest_types.getMemorySize();
+  bytes += pdgutils::getHashMapMemoryUsage(_fields) + pdgutils::getHashMapMemoryUsage(_child_types);
+  for (auto &pair : _fields)
+    bytes += pair.second.capacity() * sizeof(DIType *);
+  for (auto &pair : _child_types)
+    bytes += pair.second.capacity() * sizeof(DIType *);
+  bytes += pdgutils::getHashMapMemoryUsage(_type_names) + pdgutils::getHashMapMemoryUsage(_variable_names);
+  for (auto &pair : _type_names)
+    bytes += pair.second.capacity();
+  for (auto &pair : _variable_names)
+    bytes += pair.second.capacity();
+  return bytes;
+}
+
+void pdg::DITypeCache::clear()
+{
+  _stripped_types.clear();
+  _lowest_types.clear();
+  _fields.clear();
+  _child_types.clear();
+  _type_names.clear();
+  _variable_names.clear();
+}
@@ -1,64 +1,277 @@
 #include "DataDependencyGraph.hh"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/TypeFinder.h"
+#include "llvm/Support/ThreadPool.h"
 
 char pdg::DataDependencyGraph::ID = 0;
 
 using namespace llvm;
+
+pdg::AliasBackend pdg::ALIASBACKEND;
+
+cl::opt<pdg::AliasBackend, true> ALIASBACKEND("pdg-alias", cl::desc("alias analysis used for DATA_ALIAS edges"), cl::location(pdg::ALIASBACKEND), cl::init(pdg::AliasBackend::UNDERAPPROX),
+                                              cl::values(clEnumValN(pdg::AliasBackend::UNDERAPPROX, "underapprox", "bitcasts and loads of a slot the other value was stored to (default)"),
+                                                         clEnumValN(pdg::AliasBackend::BASICAA, "basicaa", "LLVM basic alias analysis"),
+                                                         clEnumValN(pdg::AliasBackend::TBAA, "tbaa", "LLVM basic alias analysis plus type based alias analysis"),
+                                                         clEnumValN(pdg::AliasBackend::ANDERS, "anders", "whole module inclusion based points-to analysis")));
+unsigned pdg::THREADS;
+
+cl::opt<unsigned, true> THREADS("pdg-threads", cl::desc("number of threads building the data edges of functions, 0 runs the DDG on the pass manager's analyses"), cl::location(pdg::THREADS), cl::init(0));
+
+pdg::RAWBackend pdg::RAWBACKEND;
+
+cl::opt<pdg::RAWBackend, true> RAWBACKEND("pdg-raw", cl::desc("analysis used for DATA_RAW edges"), cl::location(pdg::RAWBACKEND), cl::init(pdg::RAWBackend::MEMDEP),
+                                          cl::values(clEnumValN(pdg::RAWBackend::MEMDEP, "memdep", "the nearest clobbering store in the load's block (default)"),
+                                                     clEnumValN(pdg::RAWBackend::MEMSSA, "memssa", "every store reaching the load, walked on MemorySSA")));
+
+unsigned pdg::MEMSSAWALKLIMIT;
+
+cl::opt<unsigned, true> MEMSSAWALKLIMIT("pdg-memssa-walk-limit", cl::desc("number of clobbering accesses visited per load by -pdg-raw=memssa"), cl::location(pdg::MEMSSAWALKLIMIT), cl::init(64));
+
 bool pdg::DataDependencyGraph::runOnModule(Module &M)
 {
-  ProgramGraph &g = ProgramGraph::getInstance();
+  auto &graph_wrapper = getAnalysis<ProgramGraphWrapperPass>();
+  DataDependencyAnalyses analyses;
+  analyses.get_tli = [this](Function &F) -> TargetLibraryInfo & { return getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(F); };
+  analyses.get_ac = [this](Function &F) -> AssumptionCache & { return getAnalysis<AssumptionCacheTracker>().getAssumptionCache(F); };
+  analyses.get_mem_dep = [this](Function &F) -> MemoryDependenceResults & { return getAnalysis<MemoryDependenceWrapperPass>(F).getMemDep(); };
+  analyses.get_mssa = [this](Function &F) -> MemorySSA & { return getAnalysis<MemorySSAWrapperPass>(F).getMSSA(); };
+  buildDataDependencies(M, graph_wrapper.getPDG(), graph_wrapper.getMemReport(), analyses);
+  return false;
+}
+
+void pdg::DataDependencyGraph::buildDataDependencies(Module &M, ProgramGraph &g, MemoryReport &mem_report, DataDependencyAnalyses &analyses)
+{
+  _PDG = &g;
   if (!g.isBuild())
   {
     g.build(M);
     // TODO: add comment
     g.bindDITypeToNodes(M);
+    if (MEMREPORT)
+      mem_report.recordPhase("build", g);
   }
-  
+  if (ALIASBACKEND == AliasBackend::ANDERS)
+    _andersen.analyze(M);
+
+  std::vector<Function *> funcs;
   for (auto &F : M)
   {
-    if (F.isDeclaration() || F.empty())
+    if (F.isDeclaration() || F.empty() || !g.hasFuncWrapper(F))
       continue;
-    _mem_dep_res = &getAnalysis<MemoryDependenceWrapperPass>(F).getMemDep();
-    // setup alias query interface for each function
-    for (auto inst_iter = inst_begin(F); inst_iter != inst_end(F); inst_iter++)
+    funcs.push_back(&F);
+  }
+
+  if (THREADS > 0)
+  {
+    // functions are merged in module order, so the edges and their ids do not depend on
+    // the thread count
+    std::vector<std::vector<DataEdgeCollector::PendingEdge>> func_edges(funcs.size());
+    collectEdgesInParallel(M, funcs, func_edges, analyses);
+    for (auto &edges : func_edges)
+      addEdges(edges);
+  }
+  else
+  {
+    for (auto F : funcs)
     {
-      addDefUseEdges(*inst_iter);
-      addRAWEdges(*inst_iter);
-      addAliasEdges(*inst_iter);
-      if(auto call_inst = dyn_cast<llvm::CallInst>(&*inst_iter))
-        addCalleeEdge(*call_inst);
+      // only one of them is required, a second getAnalysis on F would rerun the first
+      MemoryDependenceResults *mem_dep_res = nullptr;
+      MemorySSA *mssa = nullptr;
+      if (RAWBACKEND == RAWBackend::MEMSSA)
+        mssa = &analyses.get_mssa(*F);
+      else
+        mem_dep_res = &analyses.get_mem_dep(*F);
+      Optional<BasicAAResult> basic_aa;
+      Optional<AAResults> aa;
+      TypeBasedAAResult tbaa;
+      if (ALIASBACKEND == AliasBackend::BASICAA || ALIASBACKEND == AliasBackend::TBAA || RAWBACKEND == RAWBackend::MEMSSA)
+      {
+        auto &tli = analyses.get_tli(*F);
+        basic_aa.emplace(M.getDataLayout(), *F, tli, analyses.get_ac(*F));
+        aa.emplace(tli);
+        aa->addAAResult(*basic_aa);
+        if (ALIASBACKEND == AliasBackend::TBAA)
+          aa->addAAResult(tbaa);
+      }
+      DataEdgeCollector collector(g, mem_dep_res, mssa, aa ? aa.getPointer() : nullptr, &_andersen);
+      collector.collect(*F);
+      addEdges(collector.getEdges());
     }
   }
-  return false;
+  _andersen.clear();
+  if (MEMREPORT)
+    mem_report.recordPhase("ddg", g);
 }
 
+void pdg::DataDependencyGraph::collectEdgesInParallel(Module &M, std::vector<Function *> &funcs, std::vector<std::vector<DataEdgeCollector::PendingEdge>> &func_edges, DataDependencyAnalyses &analyses)
+{
+  // getAnalysis and the assumption scan (which registers value handles) are not thread safe,
+  // do them up front
+  std::vector<TargetLibraryInfo> tlis;
+  std::vector<AssumptionCache *> acs;
+  for (auto F : funcs)
+  {
+    tlis.push_back(analyses.get_tli(*F));
+    AssumptionCache &ac = analyses.get_ac(*F);
+    (void)ac.assumptions();
+    acs.push_back(&ac);
+  }
+  // the workers scan as far back as the pass manager's MemDep, i.e. LLVM's -memdep-block-scan-limit
+  unsigned block_scan_limit = 0;
+  if (RAWBACKEND == RAWBackend::MEMDEP && !funcs.empty())
+    block_scan_limit = analyses.get_mem_dep(*funcs.front()).getDefaultBlockScanLimit();
+  // the DataLayout fills its struct layout map and StructType caches its sizedness on first
+  // use, without a lock. GEP decomposition in BasicAA asks for both, so compute them for every
+  // struct type in the module before the workers share them
+  const DataLayout &DL = M.getDataLayout();
+  TypeFinder struct_types;
+  struct_types.run(M, false);
+  for (auto struct_ty : struct_types)
+  {
+    if (!struct_ty->isOpaque() && struct_ty->isSized())
+      (void)DL.getStructLayout(struct_ty);
+  }
+
+  ThreadPool pool(hardware_concurrency(THREADS));
+  for (unsigned i = 0; i < funcs.size(); i++)
+  {
+    pool.async([&, i] {
+      Function &F = *funcs[i];
+      // MemDep and MemorySSA query the AA stack of LLVM's default AA pipeline, the one the
+      // pass manager hands them in the single threaded run. BasicAA gets no PhiValues: its
+      // queries create callback value handles, which register in the shared LLVMContext.
+      // MemoryDependenceResults only touches PV when instructions are removed, which the
+      // collector never does
+      DominatorTree DT(F);
+      PhiValues PV(F);
+      BasicAAResult basic_aa(M.getDataLayout(), F, tlis[i], *acs[i], &DT);
+      ScopedNoAliasAAResult scoped_noalias_aa;
+      TypeBasedAAResult tbaa;
+      AAResults mem_aa(tlis[i]);
+      mem_aa.addAAResult(basic_aa);
+      mem_aa.addAAResult(scoped_noalias_aa);
+      mem_aa.addAAResult(tbaa);
+      Optional<MemoryDependenceResults> mem_dep_res;
+      std::unique_ptr<MemorySSA> mssa;
+      if (RAWBACKEND == RAWBackend::MEMSSA)
+        mssa = std::make_unique<MemorySSA>(F, &mem_aa, &DT);
+      else
+        mem_dep_res.emplace(mem_aa, *acs[i], tlis[i], DT, PV, block_scan_limit);
 
-void pdg::DataDependencyGraph::addAliasEdges(Instruction &inst)
+      // the DATA_ALIAS queries use the same stack as the single threaded run
+      AAResults aa(tlis[i]);
+      aa.addAAResult(basic_aa);
+      if (ALIASBACKEND == AliasBackend::TBAA)
+        aa.addAAResult(tbaa);
+      bool use_aa = ALIASBACKEND == AliasBackend::BASICAA || ALIASBACKEND == AliasBackend::TBAA || RAWBACKEND == RAWBackend::MEMSSA;
+      DataEdgeCollector collector(*_PDG, mem_dep_res ? mem_dep_res.getPointer() : nullptr, mssa.get(), use_aa ? &aa : nullptr, &_andersen);
+      collector.collect(F);
+      func_edges[i] = std::move(collector.getEdges());
+    });
+  }
+  pool.wait();
+}
+
+void pdg::DataDependencyGraph::addEdges(const std::vector<DataEdgeCollector::PendingEdge> &edges)
+{
+  for (auto &edge : edges)
+    edge.src->addNeighbor(*edge.dst, edge.edge_type);
+}
+
+pdg::DataEdgeCollector::DataEdgeCollector(ProgramGraph &g, MemoryDependenceResults *mem_dep_res, MemorySSA *mssa, AAResults *aa, const AndersenAA *andersen) : _g(g), _mem_dep_res(mem_dep_res), _mssa(mssa), _andersen(andersen)
+{
+  if (aa != nullptr)
+    _batch_aa.emplace(*aa);
+}
+
+void pdg::DataEdgeCollector::collect(Function &F)
 {
-  ProgramGraph &g = ProgramGraph::getInstance();
-  Function* func = inst.getFunction();
-  for (auto inst_iter = inst_begin(func); inst_iter != inst_end(func); inst_iter++)
+  buildAliasIndex(F);
+  for (auto inst_iter = inst_begin(F); inst_iter != inst_end(F); inst_iter++)
   {
-    if (&inst == &*inst_iter)
-      continue;
-    
-    if (!inst.getType()->isPointerTy())
-      continue;
+    addDefUseEdges(*inst_iter);
+    addRAWEdges(*inst_iter);
+    addAliasEdges(*inst_iter);
+    if (auto call_inst = dyn_cast<llvm::CallInst>(&*inst_iter))
+      addCalleeEdge(*call_inst);
+  }
+}
+
+void pdg::DataEdgeCollector::buildAliasIndex(Function &F)
+{
+  unsigned order = 0;
+  for (auto inst_iter = inst_begin(F); inst_iter != inst_end(F); inst_iter++)
+  {
+    _inst_order[&*inst_iter] = order++;
+    if (inst_iter->getType()->isPointerTy())
+      _ptr_insts.push_back(&*inst_iter);
+    if (StoreInst *si = dyn_cast<StoreInst>(&*inst_iter))
+    {
+      auto stored_inst = dyn_cast<Instruction>(si->getValueOperand());
+      if (stored_inst && stored_inst->getType()->isPointerTy())
+        _stored_values[si->getPointerOperand()].push_back(stored_inst);
+    }
+  }
+}
+
+// same pairs as calling queryAliasUnderApproximate(inst, i) for every instruction i of the
+// function, but only the candidates found through the alias index are looked at
+void pdg::DataEdgeCollector::addAliasEdges(Instruction &inst)
+{
+  if (!inst.getType()->isPointerTy())
+    return;
 
-    auto alias_result = queryAliasUnderApproximate(inst, *inst_iter);
-    if (alias_result != AliasResult::NoAlias)
+  ProgramGraph &g = _g;
+  if (ALIASBACKEND != AliasBackend::UNDERAPPROX)
+  {
+    for (auto other_inst : _ptr_insts)
     {
-      Node* src = g.getNode(inst);
-      Node* dst = g.getNode(*inst_iter);
+      if (other_inst == &inst || queryAlias(inst, *other_inst) == AliasResult::NoAlias)
+        continue;
+      Node *src = g.getNode(inst);
+      Node *dst = g.getNode(*other_inst);
       if (src == nullptr || dst == nullptr)
         continue;
-      src->addNeighbor(*dst, EdgeType::DATA_ALIAS);
+      addEdge(src, dst, EdgeType::DATA_ALIAS);
     }
+    return;
+  }
+
+  SmallVector<Instruction *, 4> alias_insts;
+  if (BitCastInst *bci = dyn_cast<BitCastInst>(&inst))
+  {
+    if (auto src_inst = dyn_cast<Instruction>(bci->getOperand(0)))
+      alias_insts.push_back(src_inst);
+  }
+  else if (LoadInst *li = dyn_cast<LoadInst>(&inst))
+  {
+    auto iter = _stored_values.find(li->getPointerOperand());
+    if (iter != _stored_values.end())
+      alias_insts.append(iter->second.begin(), iter->second.end());
+  }
+  if (alias_insts.empty())
+    return;
+
+  // emit in function order, a value stored more than once gets a single edge
+  llvm::sort(alias_insts, [&](Instruction *a, Instruction *b) { return _inst_order.lookup(a) < _inst_order.lookup(b); });
+  alias_insts.erase(std::unique(alias_insts.begin(), alias_insts.end()), alias_insts.end());
+
+  for (auto alias_inst : alias_insts)
+  {
+    if (alias_inst == &inst || !alias_inst->getType()->isPointerTy())
+      continue;
+    Node *src = g.getNode(inst);
+    Node *dst = g.getNode(*alias_inst);
+    if (src == nullptr || dst == nullptr)
+      continue;
+    addEdge(src, dst, EdgeType::DATA_ALIAS);
   }
 }
 
-void pdg::DataDependencyGraph::addDefUseEdges(Instruction &inst)
+void pdg::DataEdgeCollector::addDefUseEdges(Instruction &inst)
 {
-  ProgramGraph &g = ProgramGraph::getInstance();
+  ProgramGraph &g = _g;
   for (auto user : inst.users())
   {
     Node *src = g.getNode(inst);
@@ -70,16 +283,21 @@ void pdg::DataDependencyGraph::addDefUseEdges(Instruction &inst)
       edge_type = EdgeType::ANNO_VAR;
     if (dst->getNodeType() == GraphNodeType::ANNO_GLOBAL)
       edge_type = EdgeType::ANNO_GLOBAL;
-    src->addNeighbor(*dst, edge_type);
+    addEdge(src, dst, edge_type);
   }
 }
 
-void pdg::DataDependencyGraph::addRAWEdges(Instruction &inst)
+void pdg::DataEdgeCollector::addRAWEdges(Instruction &inst)
 {
   if (!isa<LoadInst>(&inst))
     return;
+  if (_mssa != nullptr)
+  {
+    addMemorySSARAWEdges(cast<LoadInst>(inst));
+    return;
+  }
 
-  ProgramGraph &g = ProgramGraph::getInstance();
+  ProgramGraph &g = _g;
   auto dep_res = _mem_dep_res->getDependency(&inst);
   auto dep_inst = dep_res.getInst();
 
@@ -92,10 +310,58 @@ void pdg::DataDependencyGraph::addRAWEdges(Instruction &inst)
   Node *dst = g.getNode(*dep_inst);
   if (src == nullptr || dst == nullptr)
     return;
-  dst->addNeighbor(*src, EdgeType::DATA_RAW);
+  addEdge(dst, src, EdgeType::DATA_RAW);
+}
+
+void pdg::DataEdgeCollector::addMemorySSARAWEdges(LoadInst &li)
+{
+  auto load_access = _mssa->getMemoryAccess(&li);
+  Node *load_node = _g.getNode(li);
+  if (load_access == nullptr || load_node == nullptr)
+    return;
+
+  MemoryLocation load_loc = MemoryLocation::get(&li);
+  auto walker = _mssa->getWalker();
+  // clobbers in the order they are found, each walker call is bounded by -memssa-check-limit
+  SmallVector<MemoryAccess *, 8> clobbers;
+  SmallPtrSet<MemoryAccess *, 8> visited;
+  clobbers.push_back(walker->getClobberingMemoryAccess(load_access));
+  unsigned budget = MEMSSAWALKLIMIT;
+  for (unsigned i = 0; i < clobbers.size() && budget > 0; i++)
+  {
+    MemoryAccess *clobber = clobbers[i];
+    if (_mssa->isLiveOnEntryDef(clobber) || !visited.insert(clobber).second)
+      continue;
+    budget--;
+    if (auto phi = dyn_cast<MemoryPhi>(clobber))
+    {
+      for (auto &incoming : phi->incoming_values())
+        clobbers.push_back(walker->getClobberingMemoryAccess(cast<MemoryAccess>(incoming), load_loc));
+      continue;
+    }
+    auto def = cast<MemoryDef>(clobber);
+    auto si = dyn_cast<StoreInst>(def->getMemoryInst());
+    if (si == nullptr)
+    {
+      // like MemDep, step over calls that cannot see the location because it is only
+      // captured after them. Other calls and fences end the path without an edge.
+      auto call = dyn_cast<CallBase>(def->getMemoryInst());
+      if (call && isNoModRef(_batch_aa->callCapturesBefore(call, load_loc, &_mssa->getDomTree())))
+        clobbers.push_back(walker->getClobberingMemoryAccess(def->getDefiningAccess(), load_loc));
+      continue;
+    }
+    if (Node *store_node = _g.getNode(*si))
+      addEdge(store_node, load_node, EdgeType::DATA_RAW);
+
+    MemoryLocation store_loc = MemoryLocation::get(si);
+    bool kills_load = store_loc.Size.hasValue() && load_loc.Size.hasValue() && store_loc.Size.getValue() >= load_loc.Size.getValue() &&
+                      _batch_aa->alias(store_loc, load_loc) == AliasResult::MustAlias;
+    if (!kills_load)
+      clobbers.push_back(walker->getClobberingMemoryAccess(def->getDefiningAccess(), load_loc));
+  }
 }
 
-AliasResult pdg::DataDependencyGraph::queryAliasUnderApproximate(Value &v1, Value &v2)
+AliasResult pdg::DataEdgeCollector::queryAliasUnderApproximate(Value &v1, Value &v2)
 {
   if (!v1.getType()->isPointerTy() || !v2.getType()->isPointerTy())
     return AliasResult::NoAlias;
@@ -124,22 +390,104 @@ AliasResult pdg::DataDependencyGraph::queryAliasUnderApproximate(Value &v1, Valu
   return AliasResult::NoAlias;
 }
 
+AliasResult pdg::DataEdgeCollector::queryAlias(Value &v1, Value &v2)
+{
+  if (ALIASBACKEND == AliasBackend::UNDERAPPROX)
+    return queryAliasUnderApproximate(v1, v2);
+  if (!v1.getType()->isPointerTy() || !v2.getType()->isPointerTy())
+    return AliasResult::NoAlias;
+
+  // every backend here is symmetric, so (v1, v2) and (v2, v1) share an entry
+  auto key = (&v1 < &v2) ? std::make_pair(&v1, &v2) : std::make_pair(&v2, &v1);
+  auto iter = _alias_cache.find(key);
+  if (iter != _alias_cache.end())
+    return iter->second;
+
+  AliasResult res = AliasResult::MayAlias;
+  if (ALIASBACKEND == AliasBackend::ANDERS)
+    res = _andersen->alias(&v1, &v2);
+  else
+    res = _batch_aa->alias(getAliasLocation(v1), getAliasLocation(v2));
+  _alias_cache.insert(std::make_pair(key, res));
+  return res;
+}
+
+// any access through v. With tbaa the type tag of the first load / store through v is
+// attached, values that are never dereferenced get no tag.
+MemoryLocation pdg::DataEdgeCollector::getAliasLocation(Value &v)
+{
+  AAMDNodes aa_tags;
+  if (ALIASBACKEND == AliasBackend::TBAA)
+  {
+    for (auto user : v.users())
+    {
+      if (auto li = dyn_cast<LoadInst>(user))
+      {
+        if (li->getPointerOperand() == &v)
+        {
+          aa_tags = li->getAAMetadata();
+          break;
+        }
+      }
+      if (auto si = dyn_cast<StoreInst>(user))
+      {
+        if (si->getPointerOperand() == &v)
+        {
+          aa_tags = si->getAAMetadata();
+          break;
+        }
+      }
+    }
+  }
+  return MemoryLocation(&v, LocationSize::beforeOrAfterPointer(), aa_tags);
+}
 
-void pdg::DataDependencyGraph::addCalleeEdge(llvm::CallInst &inst)
+void pdg::DataEdgeCollector::addCalleeEdge(llvm::CallInst &inst)
 {
-  ProgramGraph& g = ProgramGraph::getInstance(); 
+  ProgramGraph &g = _g;
   Node* src = g.getNode(inst);
   Node* dst = g.getNode(*inst.getCalledOperand());
   if(!src || !dst)
     return;
-  src->addNeighbor(*dst, EdgeType::DATA_CALLEE);
+  addEdge(src, dst, EdgeType::DATA_CALLEE);
 }
 
 void pdg::DataDependencyGraph::getAnalysisUsage(AnalysisUsage & AU) const
 {
-  AU.addRequired<MemoryDependenceWrapperPass>();
+  AU.addRequired<ProgramGraphWrapperPass>();
+  // the on the fly pass manager runs every required function pass for each function
+  if (RAWBACKEND == RAWBackend::MEMSSA)
+    AU.addRequired<MemorySSAWrapperPass>();
+  else
+    AU.addRequired<MemoryDependenceWrapperPass>();
+  AU.addRequired<TargetLibraryInfoWrapperPass>();
+  AU.addRequired<AssumptionCacheTracker>();
   AU.setPreservesAll();
 }
 
+pdg::DataDependencyAnalyses pdg::DataDependencyAnalyses::fromFunctionAnalysisManager(FunctionAnalysisManager &FAM)
+{
+  DataDependencyAnalyses analyses;
+  analyses.get_tli = [&FAM](Function &F) -> TargetLibraryInfo & { return FAM.getResult<TargetLibraryAnalysis>(F); };
+  analyses.get_ac = [&FAM](Function &F) -> AssumptionCache & { return FAM.getResult<AssumptionAnalysis>(F); };
+  analyses.get_mem_dep = [&FAM](Function &F) -> MemoryDependenceResults & { return FAM.getResult<MemoryDependenceAnalysis>(F); };
+  analyses.get_mssa = [&FAM](Function &F) -> MemorySSA & { return FAM.getResult<MemorySSAAnalysis>(F).getMSSA(); };
+  return analyses;
+}
+
+PreservedAnalyses pdg::DataDependencyGraphPass::run(Module &M, ModuleAnalysisManager &MAM)
+{
+  auto &graph_res = MAM.getResult<ProgramGraphAnalysis>(M);
+  if (graph_res.has_data_deps)
+    return PreservedAnalyses::all();
+  // function analyses are cached by FAM and shared with the other passes of the pipeline
+  auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+  auto analyses = DataDependencyAnalyses::fromFunctionAnalysisManager(FAM);
+  DataDependencyGraph ddg;
+  ddg.buildDataDependencies(M, *graph_res.graph, *graph_res.mem_report, analyses);
+  graph_res.has_data_deps = true;
+  return PreservedAnalyses::all();
+}
+
 static RegisterPass<pdg::DataDependencyGraph>
     DDG("ddg", "Data Dependency Graph Construction", false, true);
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "FrozenGraph.hh"
+#include "PDGNode.hh"
+#include <algorithm>
+
+using namespace llvm;
+
+void pdg::FrozenGraph::clear()
+{
+  _nodes.clear();
+  _node_index.clear();
+  _num_graph_nodes = 0;
+  _out_offsets.clear();
+  _out_records.clear();
+  _out_edges.clear();
+  _in_offsets.clear();
+  _in_records.clear();
+  _in_edges.clear();
+  _range_offsets.clear();
+  _ranges.clear();
+  _num_range_edges = 0;
+  _segment_bounds.clear();
+  _segment_offsets.clear();
+  _segment_records.clear();
+}
+
+size_t pdg::FrozenGraph::getMemoryUsage() const
+{
+  return _nodes.capacity() * sizeof(Node *) + _node_index.capacity() * sizeof(unsigned) +
+         (_out_offsets.capacity() + _in_offsets.capacity()) * sizeof(unsigned) +
+         (_out_records.capacity() + _in_records.capacity()) * sizeof(EdgeRecord) +
+         (_out_edges.capacity() + _in_edges.capacity()) * sizeof(Edge *) +
+         (_range_offsets.capacity() + _segment_bounds.capacity() + _segment_offsets.capacity()) * sizeof(unsigned) +
+         _ranges.capacity() * sizeof(RangeRecord) + _segment_records.capacity() * sizeof(EdgeRecord);
+}
+
+bool pdg::FrozenGraph::hasNode(const Node &n) const
+{
+  unsigned id = n.getNodeID();
+  return id < _node_index.size() && _node_index[id] != NOT_INDEXED;
+}
+
+unsigned pdg::FrozenGraph::getIndex(const Node &n) const
+{
+  assert(hasNode(n) && "node is not part of the snapshot");
+  return _node_index[n.getNodeID()];
+}
+
+unsigned pdg::FrozenGraph::indexNode(Node *n)
+{
+  unsigned id = n->getNodeID();
+  if (id >= _node_index.size())
+    _node_index.resize(id + 1, NOT_INDEXED);
+  if (_node_index[id] != NOT_INDEXED)
+    return _node_index[id];
+  unsigned idx = _nodes.size();
+  _nodes.push_back(n);
+  _node_index[id] = idx;
+  return idx;
+}
+
+void pdg::FrozenGraph::build(const std::vector<Node *> &graph_nodes, unsigned num_node_ids)
+{
+  clear();
+  _node_index.assign(num_node_ids, NOT_INDEXED);
+  for (auto n : graph_nodes)
+    indexNode(n);
+  _num_graph_nodes = _nodes.size();
+
+  // out edges. _nodes grows while we scan it when an edge leads outside the node set
+  _out_offsets.push_back(0);
+  for (unsigned i = 0; i < _nodes.size(); i++)
+  {
+    for (auto out_edge : _nodes[i]->getOutEdges())
+    {
+      unsigned dst = indexNode(out_edge->getDstNode());
+      _out_records.push_back({dst, out_edge->getEdgeType()});
+      _out_edges.push_back(out_edge);
+    }
+    _out_offsets.push_back(_out_records.size());
+  }
+
+  // in edges mirror the out edges, bucketed by dst with a counting sort
+  unsigned num_nodes = _nodes.size();
+  _in_offsets.assign(num_nodes + 1, 0);
+  for (auto &rec : _out_records)
+    _in_offsets[rec.node + 1]++;
+  for (unsigned i = 0; i < num_nodes; i++)
+    _in_offsets[i + 1] += _in_offsets[i];
+
+  _in_records.resize(_out_records.size());
+  _in_edges.resize(_out_edges.size());
+  std::vector<unsigned> insert_pos(_in_offsets.begin(), _in_offsets.end() - 1);
+  for (unsigned src = 0; src < num_nodes; src++)
+  {
+    for (unsigned k = _out_offsets[src]; k < _out_offsets[src + 1]; k++)
+    {
+      unsigned pos = insert_pos[_out_records[k].node]++;
+      _in_records[pos] = {src, _out_records[k].edge_type};
+      _in_edges[pos] = _out_edges[k];
+    }
+  }
+}
+
+void pdg::FrozenGraph::setRangeEdges(std::vector<RangeRecord> ranges)
+{
+  _range_offsets.clear();
+  _num_range_edges = 0;
+  _segment_bounds.clear();
+  _segment_offsets.clear();
+  _segment_records.clear();
+  std::stable_sort(ranges.begin(), ranges.end(), [](const RangeRecord &a, const RangeRecord &b) { return a.src < b.src; });
+  _ranges = std::move(ranges);
+  _ranges.shrink_to_fit();
+  if (_ranges.empty())
+    return;
+
+  unsigned num_nodes = _nodes.size();
+  _range_offsets.assign(num_nodes + 1, 0);
+  for (auto &range : _ranges)
+  {
+    assert(range.src < num_nodes && range.first + range.count <= num_nodes && "range outside the snapshot");
+    _range_offsets[range.src + 1]++;
+    _num_range_edges += range.count;
+    _segment_bounds.push_back(range.first);
+    _segment_bounds.push_back(range.first + range.count);
+  }
+  for (unsigned i = 0; i < num_nodes; i++)
+    _range_offsets[i + 1] += _range_offsets[i];
+
+  // the ranges of one block are the same for every src, so there are about as many segments as
+  // blocks with control dependences
+  std::sort(_segment_bounds.begin(), _segment_bounds.end());
+  _segment_bounds.erase(std::unique(_segment_bounds.begin(), _segment_bounds.end()), _segment_bounds.end());
+  auto segmentOf = [this](unsigned idx) {
+    return std::upper_bound(_segment_bounds.begin(), _segment_bounds.end(), idx) - _segment_bounds.begin() - 1;
+  };
+  _segment_offsets.assign(_segment_bounds.size() + 1, 0);
+  for (auto &range : _ranges)
+  {
+    for (unsigned seg = segmentOf(range.first); _segment_bounds[seg] < range.first + range.count; seg++)
+      _segment_offsets[seg + 1]++;
+  }
+  for (unsigned i = 0; i < _segment_bounds.size(); i++)
+    _segment_offsets[i + 1] += _segment_offsets[i];
+  _segment_records.resize(_segment_offsets.back());
+  std::vector<unsigned> insert_pos(_segment_offsets.begin(), _segment_offsets.end() - 1);
+  for (auto &range : _ranges)
+  {
+    for (unsigned seg = segmentOf(range.first); _segment_bounds[seg] < range.first + range.count; seg++)
+      _segment_records[insert_pos[seg]++] = {range.src, range.edge_type};
+  }
+}
+
+llvm::ArrayRef<pdg::FrozenGraph::RangeRecord> pdg::FrozenGraph::getOutRangeEdges(unsigned idx) const
+{
+  if (_range_offsets.empty())
+    return {};
+  return getRange(_ranges, _range_offsets, idx);
+}
+
+llvm::ArrayRef<pdg::FrozenGraph::EdgeRecord> pdg::FrozenGraph::getInRangeEdges(unsigned idx) const
+{
+  auto iter = std::upper_bound(_segment_bounds.begin(), _segment_bounds.end(), idx);
+  if (iter == _segment_bounds.begin() || iter == _segment_bounds.end())
+    return {};
+  unsigned seg = iter - _segment_bounds.begin() - 1;
+  return getRange(_segment_records, _segment_offsets, seg);
+}
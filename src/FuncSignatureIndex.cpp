@@ -0,0 +1,73 @@
+#include "FuncSignatureIndex.hh"
+#include "PDGUtils.hh"
+
+using namespace llvm;
+
+void pdg::FuncSignatureIndex::build(Module &M)
+{
+  clear();
+  for (auto &F : M)
+  {
+    if (F.isDeclaration() || F.empty() || F.isVarArg() || !F.hasAddressTaken())
+      continue;
+    SmallVector<Type *, 8> arg_types;
+    for (auto &arg : F.args())
+      arg_types.push_back(arg.getType());
+    if (auto sig = getSignature(*F.getReturnType(), arg_types))
+      _funcs_by_signature[sig].push_back(&F);
+  }
+  _is_build = true;
+}
+
+const pdg::FuncSignatureIndex::FuncList &pdg::FuncSignatureIndex::getCandidates(CallInst &ci)
+{
+  SmallVector<Type *, 8> arg_types;
+  for (auto &arg : ci.args())
+    arg_types.push_back(arg->getType());
+  auto sig = getSignature(*ci.getType(), arg_types);
+  if (!sig)
+    return _no_candidates;
+  auto iter = _funcs_by_signature.find(sig);
+  if (iter == _funcs_by_signature.end())
+    return _no_candidates;
+  return iter->second;
+}
+
+void pdg::FuncSignatureIndex::clear()
+{
+  _funcs_by_signature.clear();
+  _canonical_types.clear();
+  _struct_ptr_types.clear();
+  _is_build = false;
+}
+
+// a pointer to a struct maps to the first pointer type seen whose struct has the same name
+// without version tag, every other type to itself
+Type *pdg::FuncSignatureIndex::getCanonicalType(Type &t)
+{
+  if (!t.isPointerTy() || t.isOpaquePointerTy() || !t.getPointerElementType()->isStructTy())
+    return &t;
+  auto iter = _canonical_types.find(&t);
+  if (iter != _canonical_types.end())
+    return iter->second;
+  auto name = pdgutils::stripVersionTag(t.getPointerElementType()->getStructName().str());
+  Type *canonical_type = _struct_ptr_types.try_emplace(name, &t).first->second;
+  _canonical_types.insert(std::make_pair(&t, canonical_type));
+  return canonical_type;
+}
+
+// the function type of the canonical types, uniqued by the context. nullptr for argument
+// types a function cannot have (e.g. metadata operands of intrinsics)
+FunctionType *pdg::FuncSignatureIndex::getSignature(Type &ret_type, ArrayRef<Type *> arg_types)
+{
+  if (!FunctionType::isValidReturnType(&ret_type))
+    return nullptr;
+  SmallVector<Type *, 8> canonical_arg_types;
+  for (auto arg_type : arg_types)
+  {
+    if (!FunctionType::isValidArgumentType(arg_type))
+      return nullptr;
+    canonical_arg_types.push_back(getCanonicalType(*arg_type));
+  }
+  return FunctionType::get(getCanonicalType(ret_type), canonical_arg_types, false);
+}
@@ -2,8 +2,29 @@
 
 using namespace llvm;
 
+size_t pdg::FunctionWrapper::getMemoryUsage() const
+{
+  size_t bytes = sizeof(FunctionWrapper);
+  bytes += (_alloca_insts.capacity() + _dbg_declare_insts.capacity() + _load_insts.capacity() + _store_insts.capacity() +
+            _call_insts.capacity() + _return_insts.capacity() + _arg_list.capacity()) *
+           sizeof(void *);
+  bytes += pdgutils::getMapVectorMemoryUsage(_arg_formal_in_tree_map) + pdgutils::getMapVectorMemoryUsage(_arg_formal_out_tree_map);
+  bytes += _inst_ordinals.getMemorySize();
+  return bytes;
+}
+
+int pdg::FunctionWrapper::getInstOrdinal(Instruction &i) const
+{
+  auto iter = _inst_ordinals.find(&i);
+  if (iter == _inst_ordinals.end())
+    return -1;
+  return iter->second;
+}
+
+// instructions are added in the order of inst_begin(F)..inst_end(F)
 void pdg::FunctionWrapper::addInst(Instruction &i)
 {
+  _inst_ordinals.try_emplace(&i, _inst_ordinals.size());
   if (AllocaInst *ai = dyn_cast<AllocaInst>(&i))
     _alloca_insts.push_back(ai);
   if (StoreInst *si = dyn_cast<StoreInst>(&i))
@@ -45,8 +66,9 @@ void pdg::FunctionWrapper::buildFormalTreeForArgs()
       // errs() << "empty di local var: " << _func->getName().str() << (di_local_var == nullptr) << " - " << (arg_alloca_inst == nullptr) << "\n";
       continue;
     }
-    Tree *arg_formal_in_tree = new Tree(*arg);
-    TreeNode *formal_in_root_node = new TreeNode(*_func, di_local_var->getType(), 0, nullptr, arg_formal_in_tree, GraphNodeType::PARAM_FORMALIN);
+    Tree *arg_formal_in_tree = _arena->create<Tree>(*arg);
+    TreeNode *formal_in_root_node = _arena->create<TreeNode>(*_arena, *_func, di_local_var->getType(), arg_formal_in_tree, 0, GraphNodeType::PARAM_FORMALIN);
+    arg_formal_in_tree->setRootNode(*formal_in_root_node);
     formal_in_root_node->setParamIdx(arg->getArgNo());
     formal_in_root_node->setDILocalVariable(*di_local_var);
     auto addr_taken_vars = pdgutils::computeAddrTakenVarsFromAlloc(*arg_alloca_inst);
@@ -54,12 +76,11 @@ void pdg::FunctionWrapper::buildFormalTreeForArgs()
     {
       formal_in_root_node->addAddrVar(*addr_taken_var);
     }
-    arg_formal_in_tree->setRootNode(*formal_in_root_node);
-    arg_formal_in_tree->build();
+    arg_formal_in_tree->build(_tree_depth);
     _arg_formal_in_tree_map.insert(std::make_pair(arg, arg_formal_in_tree));
     // build formal_out tree by copying fromal_in tree
 
-    Tree* formal_out_tree = new Tree(*arg_formal_in_tree);
+    Tree* formal_out_tree = _arena->create<Tree>(*arg_formal_in_tree);
     formal_out_tree->setBaseVal(*arg);
     TreeNode* formal_out_root_node = formal_out_tree->getRootNode();
     formal_out_root_node->setParamIdx(arg->getArgNo());
@@ -69,26 +90,26 @@ void pdg::FunctionWrapper::buildFormalTreeForArgs()
       formal_out_root_node->addAddrVar(*addr_var);
     }
     formal_out_tree->setTreeNodeType(GraphNodeType::PARAM_FORMALOUT);
-    formal_out_tree->build();
+    formal_out_tree->build(_tree_depth);
     _arg_formal_out_tree_map.insert(std::make_pair(arg, formal_out_tree));
   }
 }
 
 void pdg::FunctionWrapper::buildFormalTreesForRetVal()
 {
-  Tree* ret_formal_in_tree = new Tree();
+  Tree* ret_formal_in_tree = _arena->create<Tree>();
   DIType* func_ret_di_type = dbgutils::getFuncRetDIType(*_func);
-  TreeNode* ret_formal_in_tree_root_node = new TreeNode(*_func, func_ret_di_type, 0, nullptr, ret_formal_in_tree, GraphNodeType::PARAM_FORMALIN);
+  TreeNode* ret_formal_in_tree_root_node = _arena->create<TreeNode>(*_arena, *_func, func_ret_di_type, ret_formal_in_tree, 0, GraphNodeType::PARAM_FORMALIN);
+  ret_formal_in_tree->setRootNode(*ret_formal_in_tree_root_node);
   for (auto ret_inst : _return_insts)
   {
     auto ret_val = ret_inst->getReturnValue();
     ret_formal_in_tree_root_node->addAddrVar(*ret_val);
   }
-  ret_formal_in_tree->setRootNode(*ret_formal_in_tree_root_node);
-  ret_formal_in_tree->build();
+  ret_formal_in_tree->build(_tree_depth);
   _ret_val_formal_in_tree = ret_formal_in_tree;
 
-  Tree* ret_formal_out_tree = new Tree(*ret_formal_in_tree);
+  Tree* ret_formal_out_tree = _arena->create<Tree>(*ret_formal_in_tree);
   TreeNode *ret_formal_out_tree_root_node = ret_formal_out_tree->getRootNode();
   // copy address variables
   for (auto addr_var : ret_formal_in_tree_root_node->getAddrVars())
@@ -96,10 +117,25 @@ void pdg::FunctionWrapper::buildFormalTreesForRetVal()
     ret_formal_out_tree_root_node->addAddrVar(*addr_var);
   }
   ret_formal_out_tree->setTreeNodeType(GraphNodeType::PARAM_FORMALOUT);
-  ret_formal_out_tree->build();
+  ret_formal_out_tree->build(_tree_depth);
   _ret_val_formal_out_tree = ret_formal_out_tree;
 }
 
+std::vector<DIType *> pdg::FunctionWrapper::getTreeRootDITypes()
+{
+  // same conditions as buildFormalTreeForArgs / buildFormalTreesForRetVal
+  std::vector<DIType *> root_di_types;
+  for (auto arg : _arg_list)
+  {
+    DILocalVariable* di_local_var = getArgDILocalVar(*arg);
+    if (di_local_var == nullptr || getArgAllocaInst(*arg) == nullptr)
+      continue;
+    root_di_types.push_back(di_local_var->getType());
+  }
+  root_di_types.push_back(dbgutils::getFuncRetDIType(*_func));
+  return root_di_types;
+}
+
 DILocalVariable *pdg::FunctionWrapper::getArgDILocalVar(Argument &arg)
 {
   for (auto dbg_declare_inst : _dbg_declare_insts)
@@ -2,17 +2,64 @@
 
 using namespace llvm;
 
+bool pdg::DEMAND;
+
+unsigned pdg::TREEBUDGET;
+
+cl::opt<unsigned, true> TREEBUDGET("pdg-tree-budget", cl::desc("number of parameter tree nodes to aim for, the trees of the functions costing the most (tree size times call sites) are cut first, 0 for no budget"), cl::location(pdg::TREEBUDGET), cl::init(0));
+
+cl::opt<bool, true> DEMAND("pdg-demand", cl::desc("only build the functions connected by call edges to annotated values and globals"), cl::location(pdg::DEMAND), cl::init(false));
+
 // Generic Graph
 bool pdg::GenericGraph::hasNode(Value &v)
 {
   return (_val_node_map.find(&v) != _val_node_map.end());
 }
 
+bool pdg::GenericGraph::hasNode(Node &n) const
+{
+  unsigned id = n.getNodeID();
+  return id < _node_ids.size() && _node_ids.test(id);
+}
+
+void pdg::GenericGraph::addNode(Node &n)
+{
+  unsigned id = n.getNodeID();
+  if (id >= _node_ids.size())
+    _node_ids.resize(std::max<unsigned>(id + 1, _arena.numNodeIDs()));
+  if (_node_ids.test(id))
+    return;
+  _node_ids.set(id);
+  _node_set.push_back(&n);
+  thaw();
+}
+
+void pdg::GenericGraph::setEdgeType(Edge &e, EdgeType edge_type)
+{
+  if (e.getEdgeType() == edge_type)
+    return;
+  e.getSrcNode()->setOutEdgeType(e, edge_type);
+  thaw();
+}
+
+void pdg::GenericGraph::addEdge(Edge &e)
+{
+  unsigned id = e.getEdgeID();
+  if (id >= _edge_ids.size())
+    _edge_ids.resize(std::max<unsigned>(id + 1, _arena.numEdgeIDs()));
+  if (_edge_ids.test(id))
+    return;
+  _edge_ids.set(id);
+  _edge_set.push_back(&e);
+}
+
 pdg::Node *pdg::GenericGraph::getNode(Value &v)
 {
-  if (!hasNode(v))
+  // no insertion, the DDG workers look nodes up concurrently
+  auto iter = _val_node_map.find(&v);
+  if (iter == _val_node_map.end())
     return nullptr;
-  return _val_node_map[&v];
+  return iter->second;
 }
 
 // pretty print nodes and edges in PDG
@@ -42,16 +89,62 @@ void pdg::GenericGraph::dumpGraph()
 
   //print edges
   errs() << "=============== Edge Set ===============\n";
+  if (_is_frozen)
+  {
+    for (unsigned i = 0; i < _frozen_graph.numGraphNodes(); ++i)
+    {
+      for (auto out_edge : _frozen_graph.getOutEdgeObjects(i))
+      {
+        errs() << "edge: " << out_edge << " / " << "src[" << out_edge->getSrcNode() << "] / " << " dst[" << out_edge->getDstNode() << "]" << " / " << pdgutils::getEdgeTypeStr(out_edge->getEdgeType()) << "\n";
+      }
+      // no edge objects behind the range records
+      for (auto &range : _frozen_graph.getOutRangeEdges(i))
+      {
+        for (unsigned k = range.first; k < range.first + range.count; k++)
+          errs() << "edge: - / " << "src[" << _frozen_graph.getNode(i) << "] / " << " dst[" << _frozen_graph.getNode(k) << "]" << " / " << pdgutils::getEdgeTypeStr(range.edge_type) << "\n";
+      }
+    }
+    return;
+  }
+  materializeLazyEdges();
   for (auto node_iter = begin(); node_iter != end(); ++node_iter)
   {
     auto node = *node_iter;
-    for (auto out_edge : node->getOutEdgeSet())
+    for (auto out_edge : node->getOutEdges())
     {
       errs() << "edge: " << out_edge << " / " << "src[" << out_edge->getSrcNode() << "] / " << " dst[" << out_edge->getDstNode() << "]" << " / " << pdgutils::getEdgeTypeStr(out_edge->getEdgeType()) << "\n";
     }
   }
 }
 
+void pdg::GenericGraph::clear()
+{
+  _val_node_map.clear();
+  _edge_set.clear();
+  _node_set.clear();
+  _edge_ids.clear();
+  _node_ids.clear();
+  _frozen_graph.clear();
+  thaw();
+  _is_build = false;
+  // nothing points into the arena anymore
+  _arena.reset();
+}
+
+void pdg::GenericGraph::freeze()
+{
+  _frozen_graph.build(_node_set, _arena.numNodeIDs());
+  freezeLazyEdges(_frozen_graph);
+  _is_frozen = true;
+  _arena.setFrozenGraph(&_frozen_graph);
+}
+
+void pdg::GenericGraph::thaw()
+{
+  _is_frozen = false;
+  _arena.setFrozenGraph(nullptr);
+}
+
 // ===== Graph Traversal =====
 // DFS search
 bool pdg::GenericGraph::canReach(pdg::Node &src, pdg::Node &dst)
@@ -64,7 +157,49 @@ bool pdg::GenericGraph::canReach(pdg::Node &src, pdg::Node &dst)
 
 bool pdg::GenericGraph::canReach(pdg::Node &src, pdg::Node &dst, std::set<EdgeType> exclude_edge_types)
 {
-  std::set<Node *> visited;
+  EdgeTypeMask exclude_mask;
+  for (auto edge_type : exclude_edge_types)
+    exclude_mask.insert(edge_type);
+
+  // everything reachable from a frozen node is part of the snapshot
+  if (_is_frozen && _frozen_graph.hasNode(src))
+  {
+    if (&src == &dst)
+      return true;
+    if (!_frozen_graph.hasNode(dst))
+      return false;
+    unsigned dst_idx = _frozen_graph.getIndex(dst);
+    std::vector<bool> visited(_frozen_graph.size(), false);
+    std::stack<unsigned> idx_stack;
+    idx_stack.push(_frozen_graph.getIndex(src));
+    while (!idx_stack.empty())
+    {
+      unsigned current_idx = idx_stack.top();
+      idx_stack.pop();
+      if (visited[current_idx])
+        continue;
+      visited[current_idx] = true;
+      if (current_idx == dst_idx)
+        return true;
+      for (auto &out_edge : _frozen_graph.getOutEdges(current_idx))
+      {
+        if (exclude_mask.contains(out_edge.edge_type))
+          continue;
+        idx_stack.push(out_edge.node);
+      }
+      for (auto &range : _frozen_graph.getOutRangeEdges(current_idx))
+      {
+        if (exclude_mask.contains(range.edge_type))
+          continue;
+        for (unsigned k = range.first; k < range.first + range.count; k++)
+          idx_stack.push(k);
+      }
+    }
+    return false;
+  }
+
+  materializeLazyEdges();
+  std::vector<bool> visited(_arena.numNodeIDs(), false);
   std::stack<Node *> node_stack;
   node_stack.push(&src);
 
@@ -72,23 +207,125 @@ bool pdg::GenericGraph::canReach(pdg::Node &src, pdg::Node &dst, std::set<EdgeTy
   {
     auto current_node = node_stack.top();
     node_stack.pop();
-    if (visited.find(current_node) != visited.end())
+    if (visited[current_node->getNodeID()])
       continue;
-    visited.insert(current_node);
+    visited[current_node->getNodeID()] = true;
     if (current_node == &dst)
       return true;
-    for (auto out_edge : current_node->getOutEdgeSet())
+    // exclude path
+    for (auto out_neighbor : current_node->getOutNeighbors(~exclude_mask))
+      node_stack.push(out_neighbor);
+  }
+  return false;
+}
+
+// PDG Specific
+void pdg::ProgramGraph::clear()
+{
+  _func_wrapper_map.clear();
+  _call_wrapper_map.clear();
+  _node_di_type_map.clear();
+  _block_control_deps.clear();
+  _block_control_dep_index.clear();
+  _block_control_dep_types.clear();
+  _func_sig_index.clear();
+  GenericGraph::clear();
+}
+
+void pdg::ProgramGraph::addBlockControlDep(Node &src, BasicBlock &bb, EdgeType edge_type)
+{
+  if (!_block_control_dep_index.insert(std::make_pair(std::make_pair(&src, &bb), static_cast<unsigned>(edge_type))).second)
+    return;
+  _block_control_deps.push_back({&src, &bb, edge_type});
+}
+
+size_t pdg::ProgramGraph::getBlockControlDepMemoryUsage() const
+{
+  return _block_control_deps.capacity() * sizeof(BlockControlDep) + _block_control_dep_index.getMemorySize();
+}
+
+void pdg::ProgramGraph::setBlockControlDepType(GraphNodeType dst_node_type, EdgeType edge_type)
+{
+  for (auto &dep_type : _block_control_dep_types)
+  {
+    if (dep_type.first != dst_node_type)
+      continue;
+    if (dep_type.second != edge_type)
     {
-      // exclude path
-      if (exclude_edge_types.find(out_edge->getEdgeType()) != exclude_edge_types.end())
+      dep_type.second = edge_type;
+      thaw();
+    }
+    return;
+  }
+  _block_control_dep_types.emplace_back(dst_node_type, edge_type);
+  thaw();
+}
+
+pdg::EdgeType pdg::ProgramGraph::getBlockControlDepType(Node &dst, EdgeType edge_type) const
+{
+  for (auto &dep_type : _block_control_dep_types)
+  {
+    if (dep_type.first == dst.getNodeType())
+      return dep_type.second;
+  }
+  return edge_type;
+}
+
+void pdg::ProgramGraph::freezeLazyEdges(FrozenGraph &frozen_graph)
+{
+  // nodes are added per function in instruction order, so a block is normally a single run
+  std::vector<FrozenGraph::RangeRecord> ranges;
+  for (auto &dep : _block_control_deps)
+  {
+    if (!frozen_graph.hasNode(*dep.src))
+      continue;
+    FrozenGraph::RangeRecord run{frozen_graph.getIndex(*dep.src), 0, 0, dep.edge_type};
+    for (auto &inst : *dep.bb)
+    {
+      Node *inst_node = getNode(inst);
+      if (inst_node == nullptr || !frozen_graph.hasNode(*inst_node))
+        continue;
+      unsigned idx = frozen_graph.getIndex(*inst_node);
+      EdgeType edge_type = getBlockControlDepType(*inst_node, dep.edge_type);
+      if (run.count > 0 && idx == run.first + run.count && edge_type == run.edge_type)
+      {
+        run.count++;
         continue;
-      node_stack.push(out_edge->getDstNode());
+      }
+      if (run.count > 0)
+        ranges.push_back(run);
+      run.first = idx;
+      run.count = 1;
+      run.edge_type = edge_type;
     }
+    if (run.count > 0)
+      ranges.push_back(run);
   }
-  return false;
+  frozen_graph.setRangeEdges(std::move(ranges));
+}
+
+void pdg::ProgramGraph::materializeLazyEdges()
+{
+  if (_block_control_deps.empty())
+    return;
+  // in record order, so every node sees its control edges in the order they were computed
+  for (auto &dep : _block_control_deps)
+  {
+    for (auto &inst : *dep.bb)
+    {
+      Node *inst_node = getNode(inst);
+      // TODO: a special case when gep is used as a operand in load. Fix later
+      if (inst_node != nullptr)
+        dep.src->addNeighbor(*inst_node, getBlockControlDepType(*inst_node, dep.edge_type));
+    }
+  }
+  _block_control_deps.clear();
+  _block_control_deps.shrink_to_fit();
+  _block_control_dep_index = {};
+  // the snapshot would list the edges twice
+  thaw();
 }
 
-// PDG Specific
 void pdg::ProgramGraph::build(Module &M)
 {
   // build node for global variables
@@ -106,18 +343,26 @@ void pdg::ProgramGraph::build(Module &M)
     else if (pdgutils::isStaticGlobalVar(global_var))
       node_type = GraphNodeType::VAR_STATICALLOCMODULESCOPE;
 
-    Node * n = new Node(global_var, node_type);
+    Node * n = _arena.create<Node>(_arena, global_var, node_type);
     _val_node_map.insert(std::pair<Value *, Node *>(&global_var, n));
     addNode(*n);
   }
 
   // buildGlobalAnnotationNodes(M);
 
+  DenseSet<Function *> demanded_funcs;
+  if (DEMAND)
+    demanded_funcs = computeDemandedFunctions(M);
+  // with a tree budget the depths depend on all call sites, so trees are built after the loop
+  std::vector<FunctionWrapper *> budgeted_func_ws;
+
   for (auto &F : M)
   {
     if (F.isDeclaration() || F.empty())
       continue;
-    FunctionWrapper *func_w = new FunctionWrapper(&F);
+    if (DEMAND && !demanded_funcs.count(&F))
+      continue;
+    FunctionWrapper *func_w = _arena.create<FunctionWrapper>(&F, _arena);
     int k = 0;
     for (auto inst_iter = inst_begin(F); inst_iter != inst_end(F); inst_iter++)
     {
@@ -151,7 +396,7 @@ void pdg::ProgramGraph::build(Module &M)
         node_type = GraphNodeType::INST_FUNCALL;
       if (isa<BranchInst>(&*inst_iter))
         node_type = GraphNodeType::INST_BR;
-      Node *n = new Node(*inst_iter, node_type);
+      Node *n = _arena.create<Node>(_arena, *inst_iter, node_type);
       n->setInstructionIndex(k);
       Value *v = &*inst_iter;
       // errs() << "Added: " << v << "\n";
@@ -160,12 +405,16 @@ void pdg::ProgramGraph::build(Module &M)
       addNode(*n);
       k++;
     }
-    func_w->buildFormalTreeForArgs();
-    func_w->buildFormalTreesForRetVal();
-    addFormalTreeNodesToGraph(*func_w);
-    addNode(*func_w->getEntryNode());
-    _val_node_map.insert(std::pair<Value *, Node *>(&F, func_w->getEntryNode()));
-    _func_wrapper_map.insert(std::make_pair(&F, func_w));
+    if (TREEBUDGET > 0)
+      budgeted_func_ws.push_back(func_w);
+    else
+      addFunctionWrapper(*func_w);
+  }
+  if (TREEBUDGET > 0)
+  {
+    allocateTreeDepths(budgeted_func_ws);
+    for (auto func_w : budgeted_func_ws)
+      addFunctionWrapper(*func_w);
   }
 
   // handle call sites
@@ -185,7 +434,7 @@ void pdg::ProgramGraph::build(Module &M)
         continue;
       if (!hasFuncWrapper(*called_func))
         continue;
-      CallWrapper *cw = new CallWrapper(*ci);
+      CallWrapper *cw = _arena.create<CallWrapper>(*ci);
       FunctionWrapper *callee_fw = getFuncWrapper(*called_func);
       cw->buildActualTreeForArgs(*callee_fw);
       cw->buildActualTreesForRetVal(*callee_fw);
@@ -194,14 +443,118 @@ void pdg::ProgramGraph::build(Module &M)
   }
 
   buildGlobalAnnotationNodes(M);
+  _func_sig_index.build(M);
   _is_build = true;
 }
 
+void pdg::ProgramGraph::addFunctionWrapper(FunctionWrapper &func_w)
+{
+  func_w.buildFormalTreeForArgs();
+  func_w.buildFormalTreesForRetVal();
+  addFormalTreeNodesToGraph(func_w);
+  // the type budget is on by default, so its cuts are not silent
+  unsigned num_budget_cut = 0;
+  for (auto root_di_type : func_w.getTreeRootDITypes())
+    num_budget_cut += _arena.getTreeShapes().getShape(root_di_type, func_w.getTreeDepth()).getNumBudgetCut();
+  if (num_budget_cut > 0)
+    errs() << "[WARNING]: -pdg-tree-type-budget: " << num_budget_cut << " struct nodes in the trees of " << func_w.getFunc()->getName() << " left unexpanded\n";
+  addNode(*func_w.getEntryNode());
+  _val_node_map.insert(std::pair<Value *, Node *>(func_w.getFunc(), func_w.getEntryNode()));
+  _func_wrapper_map.insert(std::make_pair(func_w.getFunc(), &func_w));
+}
+
+// -pdg-tree-budget: a function costs its tree size times (1 + direct call sites), for the formal
+// trees and the actual trees at each call. While the estimate is over budget, the most costly
+// function loses its deepest tree level; cheap trees keep their full depth. Indirect calls
+// are not counted
+void pdg::ProgramGraph::allocateTreeDepths(std::vector<FunctionWrapper *> &func_ws)
+{
+  struct FuncTreeCost
+  {
+    FunctionWrapper *func_w;
+    std::vector<DIType *> root_di_types;
+    unsigned num_call_sites;
+    int depth;
+    int max_depth; // of the shapes at depth
+    size_t full_cost;
+    size_t cost;
+  };
+  auto &tree_shapes = _arena.getTreeShapes();
+  auto estimate = [&tree_shapes](FuncTreeCost &func_cost, int depth) {
+    func_cost.depth = depth;
+    func_cost.max_depth = 0;
+    size_t num_nodes = 0;
+    for (auto root_di_type : func_cost.root_di_types)
+    {
+      auto &shape = tree_shapes.getShape(root_di_type, depth);
+      num_nodes += shape.getNumNodes();
+      func_cost.max_depth = std::max(func_cost.max_depth, shape.getMaxDepth());
+    }
+    // in and out trees
+    func_cost.cost = 2 * num_nodes * (1 + func_cost.num_call_sites);
+  };
+
+  DenseSet<Function *> funcs;
+  for (auto func_w : func_ws)
+    funcs.insert(func_w->getFunc());
+  std::vector<FuncTreeCost> func_costs;
+  size_t total_cost = 0;
+  for (auto func_w : func_ws)
+  {
+    FuncTreeCost func_cost;
+    func_cost.func_w = func_w;
+    func_cost.root_di_types = func_w->getTreeRootDITypes();
+    func_cost.num_call_sites = 0;
+    for (auto user : func_w->getFunc()->users())
+    {
+      auto ci = dyn_cast<CallInst>(user);
+      if (ci && pdgutils::getCalledFunc(*ci) == func_w->getFunc() && funcs.count(ci->getFunction()))
+        func_cost.num_call_sites++;
+    }
+    estimate(func_cost, TREEDEPTH);
+    func_cost.full_cost = func_cost.cost;
+    total_cost += func_cost.cost;
+    func_costs.push_back(std::move(func_cost));
+  }
+
+  auto cost_less = [&func_costs](unsigned a, unsigned b) { return func_costs[a].cost < func_costs[b].cost; };
+  std::priority_queue<unsigned, std::vector<unsigned>, decltype(cost_less)> queue(cost_less);
+  for (unsigned i = 0; i < func_costs.size(); i++)
+    queue.push(i);
+  while (total_cost > TREEBUDGET && !queue.empty())
+  {
+    auto &func_cost = func_costs[queue.top()];
+    unsigned idx = queue.top();
+    queue.pop();
+    // a root with its children is as far as trees are cut
+    if (func_cost.max_depth <= 1)
+      continue;
+    total_cost -= func_cost.cost;
+    estimate(func_cost, func_cost.max_depth - 1);
+    total_cost += func_cost.cost;
+    queue.push(idx);
+  }
+
+  unsigned num_cut = 0;
+  for (auto &func_cost : func_costs)
+  {
+    if (func_cost.cost == func_cost.full_cost)
+      continue;
+    func_cost.func_w->setTreeDepth(func_cost.depth);
+    num_cut++;
+    errs() << "[WARNING]: -pdg-tree-budget: trees of " << func_cost.func_w->getFunc()->getName() << " cut to depth " << func_cost.depth << " (" << func_cost.num_call_sites << " call sites, "
+           << func_cost.full_cost << " -> " << func_cost.cost << " tree nodes)\n";
+  }
+  errs() << "pdg: -pdg-tree-budget=" << TREEBUDGET << ": about " << total_cost << " tree nodes, " << num_cut << " of " << func_costs.size() << " functions cut\n";
+  if (total_cost > TREEBUDGET)
+    errs() << "[WARNING]: -pdg-tree-budget: trees cannot be cut below " << total_cost << " nodes\n";
+}
+
 void pdg::ProgramGraph::bindDITypeToNodes(Module &M)
 {
   for (auto &F : M)
   {
-    if (F.isDeclaration())
+    if (F.isDeclaration() || !hasFuncWrapper(F))
       continue;
     FunctionWrapper *fw = _func_wrapper_map[&F];
     auto dbg_declare_insts = fw->getDbgDeclareInsts();
@@ -267,9 +620,7 @@ DIType *pdg::ProgramGraph::computeNodeDIType(Node &n)
         return nullptr;
       // DIType* retDIType = DIUtils::stripAttributes(sourceInstDIType);
       DIType *loaded_val_di_type = dbgutils::getBaseDIType(*load_addr_di_type);
-      if (loaded_val_di_type != nullptr)
-        return dbgutils::stripAttributes(*loaded_val_di_type);
-      return loaded_val_di_type;
+      return _arena.getDITypeCache().getStrippedType(loaded_val_di_type);
     }
 
     if (GlobalVariable *gv = dyn_cast<GlobalVariable>(li->getPointerOperand()))
@@ -291,21 +642,16 @@ DIType *pdg::ProgramGraph::computeNodeDIType(Node &n)
     if (!base_addr_di_type)
       return nullptr;
 
-    DIType* base_addr_lowest_di_type = dbgutils::getLowestDIType(*base_addr_di_type);
+    auto &di_types = _arena.getDITypeCache();
+    DIType* base_addr_lowest_di_type = di_types.getLowestType(base_addr_di_type);
     if (!base_addr_lowest_di_type)
       return nullptr;
-    if (!dbgutils::isStructType(*base_addr_lowest_di_type))
-      return nullptr;
-    if (auto dict = dyn_cast<DICompositeType>(base_addr_lowest_di_type))
+    // empty unless the lowest type is a struct
+    for (auto field_di_type : di_types.getFields(base_addr_lowest_di_type))
     {
-      auto di_node_arr = dict->getElements();
-      for (unsigned i = 0; i < di_node_arr.size(); ++i)
-      {
-        DIType *field_di_type = dyn_cast<DIType>(di_node_arr[i]);
-        assert(field_di_type != nullptr && "fail to retrive field di type (computeNodeDIType)");
-        if (pdgutils::isGEPOffsetMatchDIOffset(*field_di_type, *gep))
-          return field_di_type;
-      }
+      assert(field_di_type != nullptr && "fail to retrive field di type (computeNodeDIType)");
+      if (pdgutils::isGEPOffsetMatchDIOffset(*field_di_type, *gep))
+        return field_di_type;
     }
   }
   // cast inst
@@ -371,7 +717,7 @@ void pdg::ProgramGraph::buildGlobalAnnotationNodes(Module &M)
   auto global_annos = M.getNamedGlobal("llvm.global.annotations");
   if (global_annos)
   {
-    Node* global_anno_node = new Node(*global_annos, GraphNodeType::ANNO_GLOBAL);
+    Node* global_anno_node = _arena.create<Node>(_arena, *global_annos, GraphNodeType::ANNO_GLOBAL);
     _val_node_map.insert(std::pair<Value *, Node *>(global_annos, global_anno_node));
     addNode(*global_anno_node);
     auto casted_array = cast<ConstantArray>(global_annos->getOperand(0));
@@ -388,7 +734,7 @@ void pdg::ProgramGraph::buildGlobalAnnotationNodes(Module &M)
         {
           // llvm::errs() << "MAKING GLOBAL! \n ";
           // couldn't this also be a module static variable?
-          n = new Node(*annotated_gv, GraphNodeType::VAR_STATICALLOCGLOBALSCOPE);
+          n = _arena.create<Node>(_arena, *annotated_gv, GraphNodeType::VAR_STATICALLOCGLOBALSCOPE);
           _val_node_map.insert(std::pair<Value *, Node *>(annotated_gv, n));
           addNode(*n);
         }
@@ -399,6 +745,103 @@ void pdg::ProgramGraph::buildGlobalAnnotationNodes(Module &M)
   }
 }
 
+// functions a constant refers to, looking through casts, geps, aggregates and global initializers
+static void collectReferencedFunctions(Constant &c, SmallPtrSetImpl<Value *> &visited, std::vector<Function *> &funcs)
+{
+  if (!visited.insert(&c).second)
+    return;
+  if (auto F = dyn_cast<Function>(&c))
+  {
+    funcs.push_back(F);
+    return;
+  }
+  if (auto gv = dyn_cast<GlobalVariable>(&c))
+  {
+    if (gv->hasInitializer())
+      collectReferencedFunctions(*gv->getInitializer(), visited, funcs);
+    return;
+  }
+  for (auto &op : c.operands())
+  {
+    if (auto op_c = dyn_cast<Constant>(op))
+      collectReferencedFunctions(*op_c, visited, funcs);
+  }
+}
+
+// functions with an instruction using v, looking through constants and the globals they initialize
+static void collectUsingFunctions(Value &v, SmallPtrSetImpl<Value *> &visited, std::vector<Function *> &funcs)
+{
+  for (auto user : v.users())
+  {
+    if (auto inst = dyn_cast<Instruction>(user))
+      funcs.push_back(inst->getFunction());
+    else if (isa<Constant>(user) && visited.insert(user).second)
+      collectUsingFunctions(*user, visited, funcs);
+  }
+}
+
+// the functions -pdg-demand builds: the ones holding llvm.var.annotation calls, annotated
+// functions and the users of annotated globals, closed over their callers and then over the
+// callees of everything reached. Function pointers count as call edges
+DenseSet<Function *> pdg::ProgramGraph::computeDemandedFunctions(Module &M)
+{
+  std::vector<Function *> roots;
+  SmallPtrSet<Value *, 32> visited_users;
+  if (auto var_anno = M.getFunction("llvm.var.annotation"))
+    collectUsingFunctions(*var_anno, visited_users, roots);
+  auto global_annos = M.getNamedGlobal("llvm.global.annotations");
+  if (global_annos && global_annos->hasInitializer())
+  {
+    if (auto casted_array = dyn_cast<ConstantArray>(global_annos->getInitializer()))
+    {
+      for (auto &op : casted_array->operands())
+      {
+        auto annotated_val = cast<Constant>(op)->getOperand(0)->stripPointerCasts();
+        if (auto F = dyn_cast<Function>(annotated_val))
+          roots.push_back(F);
+        else
+          collectUsingFunctions(*annotated_val, visited_users, roots);
+      }
+    }
+  }
+
+  if (roots.empty())
+    errs() << "[WARNING]: -pdg-demand found no annotated values or globals, no function is built\n";
+
+  // callers first, so that the callees of every caller are reached as well
+  DenseSet<Function *> callers_reached;
+  std::vector<Function *> worklist(roots);
+  while (!worklist.empty())
+  {
+    Function *F = worklist.back();
+    worklist.pop_back();
+    if (!callers_reached.insert(F).second)
+      continue;
+    visited_users.clear();
+    collectUsingFunctions(*F, visited_users, worklist);
+  }
+
+  DenseSet<Function *> demanded_funcs;
+  SmallPtrSet<Value *, 32> visited_consts;
+  worklist.assign(callers_reached.begin(), callers_reached.end());
+  while (!worklist.empty())
+  {
+    Function *F = worklist.back();
+    worklist.pop_back();
+    if (!demanded_funcs.insert(F).second)
+      continue;
+    for (auto &inst : instructions(F))
+    {
+      for (auto &op : inst.operands())
+      {
+        if (auto c = dyn_cast<Constant>(op))
+          collectReferencedFunctions(*c, visited_consts, worklist);
+      }
+    }
+  }
+  return demanded_funcs;
+}
+
 void pdg::ProgramGraph::dumpNodeLineNumbers()
 {
   std::ofstream outLineNumbers;
@@ -0,0 +1,31 @@
+#include "GraphArena.hh"
+#include "PDGNode.hh"
+#include "PDGEdge.hh"
+#include "Tree.hh"
+#include "FunctionWrapper.hh"
+#include "CallWrapper.hh"
+#include <algorithm>
+
+pdg::GraphArena::~GraphArena()
+{
+  reset();
+}
+
+void pdg::GraphArena::reset()
+{
+  // wrappers and trees only point at nodes, so the order does not matter
+  _call_wrapper_alloc.DestroyAll();
+  _func_wrapper_alloc.DestroyAll();
+  _tree_alloc.DestroyAll();
+  _edge_alloc.DestroyAll();
+  _tree_node_alloc.DestroyAll();
+  _node_alloc.DestroyAll();
+  _string_table.clear();
+  _tree_shapes.clear();
+  _di_types.clear();
+  _num_node_ids = 0;
+  _num_edge_ids = 0;
+  _edge_keys.clear();
+  _frozen_graph = nullptr;
+  std::fill(std::begin(_num_objects), std::end(_num_objects), 0);
+}
@@ -0,0 +1,203 @@
+#include "MemoryReport.hh"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Process.h"
+#include <sys/resource.h>
+
+using namespace llvm;
+
+void pdg::MemoryReport::clear()
+{
+  _phases.clear();
+  _nodes.clear();
+  _tree_nodes.clear();
+  _edges.clear();
+  _structures.clear();
+  _total_bytes = 0;
+}
+
+size_t pdg::MemoryReport::getPeakRSS()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss; // bytes
+#else
+  return usage.ru_maxrss * 1024; // kilobytes
+#endif
+}
+
+void pdg::MemoryReport::recordPhase(StringRef name, ProgramGraph &g)
+{
+  auto &arena = g.getArena();
+  _phases.push_back({name.str(), getPeakRSS(), sys::Process::GetMallocUsage(),
+                     arena.numCreated<Node>() + arena.numCreated<TreeNode>(), arena.numCreated<Edge>()});
+}
+
+void pdg::MemoryReport::computeFootprint(ProgramGraph &g)
+{
+  _nodes.clear();
+  _tree_nodes.clear();
+  _edges.clear();
+  _structures.clear();
+
+  // graph nodes plus whatever hangs off them, e.g. actual tree nodes that are never added
+  auto &arena = g.getArena();
+  std::vector<bool> seen(arena.numNodeIDs(), false);
+  std::vector<Node *> worklist(g.begin(), g.end());
+  for (auto n : worklist)
+    seen[n->getNodeID()] = true;
+  while (!worklist.empty())
+  {
+    Node *n = worklist.back();
+    worklist.pop_back();
+    if (n->isTreeNode())
+    {
+      _tree_nodes[n->getNodeType()].add(n->getMemoryUsage());
+      // the side tables of a tree hold the addr vars and access tags of all its nodes
+      auto tree_node = static_cast<TreeNode *>(n);
+      if (tree_node->isRootNode())
+        _structures["trees"].add(tree_node->getTree()->getMemoryUsage() - sizeof(Tree), 0);
+    }
+    else
+      _nodes[n->getNodeType()].add(n->getMemoryUsage());
+    for (auto out_edge : n->getOutEdges())
+      _edges[out_edge->getEdgeType()].add(sizeof(Edge));
+    for (auto neighbor : n->getOutNeighbors())
+    {
+      if (!seen[neighbor->getNodeID()])
+      {
+        seen[neighbor->getNodeID()] = true;
+        worklist.push_back(neighbor);
+      }
+    }
+    for (auto neighbor : n->getInNeighbors())
+    {
+      if (!seen[neighbor->getNodeID()])
+      {
+        seen[neighbor->getNodeID()] = true;
+        worklist.push_back(neighbor);
+      }
+    }
+  }
+
+  size_t num_trees = arena.numCreated<Tree>();
+  _structures["trees"].add(num_trees * sizeof(Tree), num_trees);
+  for (auto &pair : g.getFuncWrapperMap())
+    _structures["function_wrappers"].add(pair.second->getMemoryUsage());
+  for (auto &pair : g.getCallWrapperMap())
+    _structures["call_wrappers"].add(pair.second->getMemoryUsage());
+  _structures["val_node_map"].add(pdgutils::getHashMapMemoryUsage(g.getValueNodeMap()), g.getValueNodeMap().size());
+  _structures["func_wrapper_map"].add(pdgutils::getHashMapMemoryUsage(g.getFuncWrapperMap()), g.getFuncWrapperMap().size());
+  _structures["call_wrapper_map"].add(pdgutils::getHashMapMemoryUsage(g.getCallWrapperMap()), g.getCallWrapperMap().size());
+  _structures["node_di_map"].add(pdgutils::getHashMapMemoryUsage(g.getNodeDIMap()), g.getNodeDIMap().size());
+  _structures["edge_keys"].add(arena.getEdgeKeys().getMemorySize(), arena.getEdgeKeys().size());
+  _structures["node_set"].add(g.getNodeSet().capacity() * sizeof(Node *), g.getNodeSet().size());
+  _structures["block_control_deps"].add(g.getBlockControlDepMemoryUsage(), g.getBlockControlDeps().size());
+  _structures["strings"].add(arena.getStringTable().getMemoryUsage(), arena.getStringTable().size());
+  _structures["di_type_cache"].add(arena.getDITypeCache().getMemoryUsage(), arena.getDITypeCache().size());
+  _structures["tree_shapes"].add(arena.getTreeShapes().getMemoryUsage(), arena.getTreeShapes().size());
+  if (g.isFrozen())
+    _structures["frozen_graph"].add(g.getFrozenGraph().getMemoryUsage(), g.getFrozenGraph().size());
+
+  _total_bytes = 0;
+  for (auto &pair : _nodes)
+    _total_bytes += pair.second.bytes;
+  for (auto &pair : _tree_nodes)
+    _total_bytes += pair.second.bytes;
+  for (auto &pair : _edges)
+    _total_bytes += pair.second.bytes;
+  for (auto &pair : _structures)
+    _total_bytes += pair.second.bytes;
+}
+
+void pdg::MemoryReport::print(raw_ostream &os) const
+{
+  auto printUsage = [&](StringRef name, const Usage &usage) {
+    os << "  " << left_justify(name, 32) << right_justify(std::to_string(usage.count), 10) << right_justify(std::to_string(usage.bytes), 14) << "\n";
+  };
+  os << "===== PDG memory report =====\n";
+  os << "  " << left_justify("structure", 32) << right_justify("count", 10) << right_justify("bytes", 14) << "\n";
+  for (auto &pair : _nodes)
+    printUsage("node " + pdgutils::getNodeTypeStr(pair.first), pair.second);
+  for (auto &pair : _tree_nodes)
+    printUsage("tree node " + pdgutils::getNodeTypeStr(pair.first), pair.second);
+  for (auto &pair : _edges)
+    printUsage("edge " + pdgutils::getEdgeTypeStr(pair.first), pair.second);
+  for (auto &pair : _structures)
+    printUsage(pair.first, pair.second);
+  os << "  total bytes: " << _total_bytes << "\n";
+  for (auto &phase : _phases)
+    os << "  phase " << phase.name << ": peak rss " << phase.peak_rss / 1024 << " KB, malloc " << phase.malloc_bytes / 1024 << " KB, "
+       << phase.num_nodes << " nodes, " << phase.num_edges << " edges\n";
+}
+
+void pdg::MemoryReport::writeJSON(raw_ostream &os) const
+{
+  json::OStream J(os, 2);
+  auto writeUsage = [&](const Usage &usage) {
+    J.object([&] {
+      J.attribute("count", static_cast<int64_t>(usage.count));
+      J.attribute("bytes", static_cast<int64_t>(usage.bytes));
+    });
+  };
+  J.object([&] {
+    J.attributeArray("phases", [&] {
+      for (auto &phase : _phases)
+      {
+        J.object([&] {
+          J.attribute("name", phase.name);
+          J.attribute("peak_rss_bytes", static_cast<int64_t>(phase.peak_rss));
+          J.attribute("malloc_bytes", static_cast<int64_t>(phase.malloc_bytes));
+          J.attribute("nodes", static_cast<int64_t>(phase.num_nodes));
+          J.attribute("edges", static_cast<int64_t>(phase.num_edges));
+        });
+      }
+    });
+    J.attributeObject("nodes", [&] {
+      for (auto &pair : _nodes)
+      {
+        J.attributeBegin(pdgutils::getNodeTypeStr(pair.first));
+        writeUsage(pair.second);
+        J.attributeEnd();
+      }
+    });
+    J.attributeObject("tree_nodes", [&] {
+      for (auto &pair : _tree_nodes)
+      {
+        J.attributeBegin(pdgutils::getNodeTypeStr(pair.first));
+        writeUsage(pair.second);
+        J.attributeEnd();
+      }
+    });
+    J.attributeObject("edges", [&] {
+      for (auto &pair : _edges)
+      {
+        J.attributeBegin(pdgutils::getEdgeTypeStr(pair.first));
+        writeUsage(pair.second);
+        J.attributeEnd();
+      }
+    });
+    for (auto &pair : _structures)
+    {
+      J.attributeBegin(pair.first);
+      writeUsage(pair.second);
+      J.attributeEnd();
+    }
+    J.attribute("total_bytes", static_cast<int64_t>(_total_bytes));
+  });
+  os << "\n";
+}
+
+bool pdg::MemoryReport::writeJSONFile(StringRef filename) const
+{
+  std::error_code EC;
+  raw_fd_ostream os(filename, EC);
+  if (EC)
+  {
+    errs() << "[WARNING]: cannot write " << filename << ": " << EC.message() << "\n";
+    return false;
+  }
+  writeJSON(os);
+  return true;
+}
@@ -8,12 +8,14 @@ void pdg::PDGCallGraph::build(Module &M)
   {
     if (F.isDeclaration() || F.empty())
       continue;
-    Node* n = new Node(F, GraphNodeType::FUNC);
+    Node* n = _arena.create<Node>(_arena, F, GraphNodeType::FUNC);
     _val_node_map.insert(std::make_pair(&F, n));
     addNode(*n);
   }
 
   // connect nodes
+  if (!_func_sig_index.isBuild())
+    _func_sig_index.build(M);
   for (auto &F : M)
   {
     if (F.isDeclaration() || F.empty())
@@ -49,69 +51,17 @@ void pdg::PDGCallGraph::build(Module &M)
   _is_build = true;
 }
 
-bool pdg::PDGCallGraph::isFuncSignatureMatch(CallInst &ci, llvm::Function &f)
+const pdg::FuncSignatureIndex::FuncList &pdg::PDGCallGraph::getIndirectCallCandidates(CallInst &ci, Module &M)
 {
-  if (f.isVarArg())
-    return false;
-  auto actual_arg_list_size = ci.arg_size();
-  auto formal_arg_list_size = f.arg_size();
-  if (actual_arg_list_size != formal_arg_list_size)
-    return false;
-  // compare return type
-  auto actual_ret_type = ci.getType();
-  auto formal_ret_type = f.getReturnType();
-  if (!isTypeEqual(*actual_ret_type, *formal_ret_type))
-    return false;
-  
-  for (unsigned i = 0; i < actual_arg_list_size; i++)
-  {
-    auto actual_arg = ci.getOperand(i);
-    auto formal_arg = f.getArg(i);
-    if (!isTypeEqual(*actual_arg->getType(), *formal_arg->getType()))
-      return false;
-  }
-  return true;
-}
-
-bool pdg::PDGCallGraph::isTypeEqual(Type& t1, Type &t2)
-{
-  if (&t1 == &t2)
-    return true;
-  // need to compare name for sturct, due to llvm-link duplicate struct types
-  if (!t1.isPointerTy() || !t2.isPointerTy())
-    return false;
-
-  auto t1_pointed_ty = t1.getPointerElementType();
-  auto t2_pointed_ty = t2.getPointerElementType();
-
-  if (!t1_pointed_ty->isStructTy() || !t2_pointed_ty->isStructTy())
-    return false;
-  
-  auto t1_name = pdgutils::stripVersionTag(t1_pointed_ty->getStructName().str());
-  auto t2_name = pdgutils::stripVersionTag(t2_pointed_ty->getStructName().str());
-
-  return (t1_name == t2_name);
-}
-
-std::set<Function *> pdg::PDGCallGraph::getIndirectCallCandidates(CallInst &ci, Module &M)
-{
-  Type *call_func_ty = ci.getFunctionType();
-  assert(call_func_ty != nullptr && "cannot find indirect call for null function type!\n");
-  std::set<Function *> ind_call_cand;
-  for (auto &F : M)
-  {
-    if (F.isDeclaration() || F.empty())
-      continue;
-    if (isFuncSignatureMatch(ci, F))
-      ind_call_cand.insert(&F);
-  }
-  return ind_call_cand;
+  if (!_func_sig_index.isBuild())
+    _func_sig_index.build(M);
+  return _func_sig_index.getCandidates(ci);
 }
 
 bool pdg::PDGCallGraph::canReach(Node &src, Node &sink)
 {
     std::queue<Node*> node_queue;
-    std::unordered_set<Node *> seen_node;
+    std::vector<bool> seen_node(_arena.numNodeIDs(), false);
     node_queue.push(&src);
     while (!node_queue.empty())
     {
@@ -119,9 +69,9 @@ bool pdg::PDGCallGraph::canReach(Node &src, Node &sink)
       node_queue.pop();
       if (n == &sink)
         return true;
-      if (seen_node.find(n) != seen_node.end())
+      if (seen_node[n->getNodeID()])
         continue;
-      seen_node.insert(n);
+      seen_node[n->getNodeID()] = true;
 
       for (auto out_neighbor : n->getOutNeighbors())
       {
@@ -138,8 +88,12 @@ void pdg::PDGCallGraph::dump()
     if (Function *f = dyn_cast<Function>(pair.first))
     {
       errs() << f->getName() << ": \n";
+      // a callee can be reached by a direct and an indirect call edge, print it once
+      SmallPtrSet<Node *, 8> printed;
       for (auto out_node : pair.second->getOutNeighbors())
       {
+        if (!printed.insert(out_node).second)
+          continue;
         if (Function *callee = dyn_cast<Function>(out_node->getValue()))
           errs() << "\t\t" << callee->getName() << "\n";
       }
@@ -1,3 +0,0 @@
-#include "PDGEdge.hh"
-
-unsigned int pdg::Edge::edge_count = -1;
\ No newline at end of file
@@ -2,75 +2,58 @@
 
 using namespace llvm;
 
-unsigned int pdg::Node::node_count = 0;
-
-void pdg::Node::addNeighbor(Node &neighbor, EdgeType edge_type)
+size_t pdg::Node::getMemoryUsage() const
 {
-  if (hasOutNeighborWithEdgeType(neighbor, edge_type))
-    return;
-  Edge *edge = new Edge(this, &neighbor, edge_type);
-  addOutEdge(*edge);
-  neighbor.addInEdge(*edge);
+  size_t bytes = sizeof(Node);
+  bytes += (_in_edge_set.capacity() + _out_edge_set.capacity()) * sizeof(Edge *);
+  return bytes;
 }
 
-std::set<pdg::Node *> pdg::Node::getInNeighbors()
+llvm::ArrayRef<pdg::FrozenGraph::RangeRecord> pdg::Node::getFrozenOutRanges() const
 {
-  std::set<Node *> in_neighbors;
-  for (auto edge : _in_edge_set)
-  {
-    in_neighbors.insert(edge->getSrcNode());
-  }
-  return in_neighbors;
+  auto frozen_graph = _arena->getFrozenGraph();
+  if (frozen_graph == nullptr || !frozen_graph->hasNode(*this))
+    return {};
+  return frozen_graph->getOutRangeEdges(frozen_graph->getIndex(*this));
 }
 
-std::set<pdg::Node *> pdg::Node::getInNeighborsWithDepType(pdg::EdgeType edge_type)
+llvm::ArrayRef<pdg::FrozenGraph::EdgeRecord> pdg::Node::getFrozenInRecords() const
 {
-  std::set<Node *> in_neighbors_with_dep_type;
-  for (auto edge : _in_edge_set)
-  {
-    if (edge->getEdgeType() == edge_type)
-      in_neighbors_with_dep_type.insert(edge->getDstNode());
-  }
-  return in_neighbors_with_dep_type;
+  auto frozen_graph = _arena->getFrozenGraph();
+  if (frozen_graph == nullptr || !frozen_graph->hasNode(*this))
+    return {};
+  return frozen_graph->getInRangeEdges(frozen_graph->getIndex(*this));
 }
 
-std::set<pdg::Node *> pdg::Node::getOutNeighbors()
+void pdg::Node::addNeighbor(Node &neighbor, EdgeType edge_type)
 {
-  std::set<Node *> out_neighbors;
-  for (auto edge : _out_edge_set)
-  {
-    out_neighbors.insert(edge->getDstNode());
-  }
-  return out_neighbors;
+  if (!_arena->insertEdgeKey(node_ID, neighbor.node_ID, edge_type))
+    return;
+  Edge *edge = _arena->create<Edge>(this, &neighbor, edge_type, _arena->allocEdgeID());
+  addOutEdge(*edge);
+  neighbor.addInEdge(*edge);
 }
 
-std::set<pdg::Node *> pdg::Node::getOutNeighborsWithDepType(pdg::EdgeType edge_type)
+// addNeighbor keeps one edge per (neighbor, type). If neighbor is already reached by an edge
+// of the new type, both edges stay and share one key
+void pdg::Node::setOutEdgeType(Edge &edge, EdgeType edge_type)
 {
-  std::set<Node *> out_neighbors_with_dep_type;
-  for (auto edge : _out_edge_set)
-  {
-    if (edge->getEdgeType() == edge_type)
-      out_neighbors_with_dep_type.insert(edge->getDstNode());
-  }
-  return out_neighbors_with_dep_type;
+  assert(edge.getSrcNode() == this && "not an out edge of this node");
+  EdgeType old_type = edge.getEdgeType();
+  if (old_type == edge_type)
+    return;
+  Node &neighbor = *edge.getDstNode();
+  edge.setEdgeType(edge_type);
+  _arena->eraseEdgeKey(node_ID, neighbor.node_ID, old_type);
+  _arena->insertEdgeKey(node_ID, neighbor.node_ID, edge_type);
 }
 
 bool pdg::Node::hasInNeighborWithEdgeType(Node &n, EdgeType edge_type)
 {
-  for (auto e : _in_edge_set)
-  {
-    if (e->getSrcNode() == &n && e->getEdgeType() == edge_type)
-      return true;
-  }
-  return false;
+  return n.hasOutNeighborWithEdgeType(*this, edge_type);
 }
 
 bool pdg::Node::hasOutNeighborWithEdgeType(Node &n, EdgeType edge_type)
 {
-  for (auto e : _out_edge_set)
-  {
-    if (e->getDstNode() == &n && e->getEdgeType() == edge_type)
-      return true;
-  }
-  return false;
+  return _arena->hasEdgeKey(node_ID, n.node_ID, edge_type);
 }
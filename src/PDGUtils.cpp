@@ -180,42 +180,13 @@ inst_iterator pdg::pdgutils::getInstIter(Instruction &i)
   return inst_end(f);
 }
 
-std::set<Instruction *> pdg::pdgutils::getInstructionBeforeInst(Instruction &i)
+std::vector<Value *> pdg::pdgutils::computeAddrTakenVarsFromAlloc(AllocaInst &ai)
 {
-  Function* f = i.getFunction();
-  auto stop = getInstIter(i);
-  std::set<Instruction*> insts_before;
-  for (auto inst_iter = inst_begin(f); inst_iter != inst_end(f); inst_iter++)
-  {
-    if (inst_iter == stop)
-      return insts_before;
-    insts_before.insert(&*inst_iter);
-  }
-  return insts_before;
-}
-
-std::set<Instruction *> pdg::pdgutils::getInstructionAfterInst(Instruction &i)
-{
-  Function* f = i.getFunction();
-  std::set<Instruction*> insts_after;
-  auto start = getInstIter(i);
-  if (start == inst_end(f))
-    return  insts_after;
-  start++;
-  for (auto inst_iter = start; inst_iter != inst_end(f); inst_iter++)
-  {
-    insts_after.insert(&*inst_iter);
-  }
-  return insts_after;
-}
-
-std::set<Value *> pdg::pdgutils::computeAddrTakenVarsFromAlloc(AllocaInst &ai)
-{
-  std::set<Value *> addr_taken_vars;
+  std::vector<Value *> addr_taken_vars;
   for (auto user : ai.users())
   {
     if (isa<LoadInst>(user))
-      addr_taken_vars.insert(user);
+      addr_taken_vars.push_back(user);
   }
   return addr_taken_vars;
 }
@@ -241,22 +212,20 @@ std::string pdg::pdgutils::stripFuncNameVersionNumber(std::string func_name)
 
 std::string pdg::pdgutils::computeTreeNodeID(TreeNode &tree_node)
 {
+  auto &di_types = tree_node.getArena().getDITypeCache();
   std::string parent_type_name = "";
-  std::string node_field_name = "";
   TreeNode* parent_node = tree_node.getParentNode();
   if (parent_node != nullptr)
   {
     auto parent_di_type = dbgutils::stripMemberTag(*parent_node->getDIType());
     if (parent_di_type != nullptr)
-      parent_type_name = dbgutils::getSourceLevelTypeName(*parent_di_type);
+      parent_type_name = di_types.getTypeName(parent_di_type);
   }
 
   if (!tree_node.getDIType())
     return parent_type_name;
-  DIType* node_di_type = dbgutils::stripAttributes(*tree_node.getDIType());
-  node_field_name = dbgutils::getSourceLevelVariableName(*node_di_type);
-  
-  return (parent_type_name + node_field_name);
+  DIType* node_di_type = di_types.getStrippedType(tree_node.getDIType());
+  return (parent_type_name + di_types.getVariableName(node_di_type));
 }
 
 std::string pdg::pdgutils::stripVersionTag(std::string str)
@@ -353,8 +322,20 @@ std::string pdg::pdgutils::getEdgeTypeStr(EdgeType edge_type)
     return "ControlDep_CallRet";
   case EdgeType::DATA_DEF_USE:
     return "DataDepEdge_DefUse";
+  case EdgeType::DATA_GLOBAL_DEF_USE:
+    return "DataDepEdge_GlobalDefUse";
   case EdgeType::DATA_RAW:
     return "DataDepEdge_RAW";
+  case EdgeType::DATA_INDIRECT_RET:
+    return "DataDepEdge_Indirect_Ret";
+  case EdgeType::DATA_ARGPASS_IN:
+    return "DataDepEdge_ArgPass_In";
+  case EdgeType::DATA_ARGPASS_OUT:
+    return "DataDepEdge_ArgPass_Out";
+  case EdgeType::DATA_ARGPASS_INDIRECT_IN:
+    return "DataDepEdge_ArgPass_Indirect_In";
+  case EdgeType::DATA_ARGPASS_INDIRECT_OUT:
+    return "DataDepEdge_ArgPass_Indirect_Out";
   // case EdgeType::DATA_READ:
   //   return "DATA_READ";
   case EdgeType::DATA_ALIAS:
@@ -0,0 +1,35 @@
+#include "DataDependencyGraph.hh"
+#include "ControlDependencyGraph.hh"
+#include "ProgramDependencyGraph.hh"
+#include "zincPrinter.hh"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/PassPlugin.h"
+
+using namespace llvm;
+
+// new pass manager entry point: opt -load-pass-plugin libpdg.so -passes=minizinc. The legacy
+// passes stay registered through RegisterPass for opt -enable-new-pm=0 -load libpdg.so
+static bool parseModulePipeline(StringRef name, ModulePassManager &MPM, ArrayRef<PassBuilder::PipelineElement>)
+{
+  if (name == "ddg")
+    MPM.addPass(pdg::DataDependencyGraphPass());
+  else if (name == "cdg")
+    MPM.addPass(pdg::ControlDependencyGraphPass());
+  else if (name == "pdg")
+    MPM.addPass(pdg::ProgramDependencyGraphPass());
+  else if (name == "minizinc")
+    MPM.addPass(pdg::MiniZincPrinterPass());
+  else
+    return false;
+  return true;
+}
+
+extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo()
+{
+  return {LLVM_PLUGIN_API_VERSION, "pdg", LLVM_VERSION_STRING, [](PassBuilder &PB) {
+            PB.registerAnalysisRegistrationCallback([](ModuleAnalysisManager &MAM) {
+              MAM.registerPass([] { return pdg::ProgramGraphAnalysis(); });
+            });
+            PB.registerPipelineParsingCallback(parseModulePipeline);
+          }};
+}
@@ -9,20 +9,34 @@ bool pdg::DEBUG;
 
 cl::opt<bool, true> DEBUG("pdg-debug", cl::desc("print debug messages"), cl::value_desc("print debug messages"), cl::location(pdg::DEBUG), cl::init(false));
 
+bool pdg::MEMREPORT;
+
+cl::opt<bool, true> MEMREPORT("pdg-mem-report", cl::desc("report the memory used by each graph structure and the peak RSS of each phase (pdg_mem_report.json)"), cl::location(pdg::MEMREPORT), cl::init(false));
+
 void pdg::ProgramDependencyGraph::getAnalysisUsage(AnalysisUsage &AU) const
 {
+  AU.addRequired<ProgramGraphWrapperPass>();
   AU.addRequired<DataDependencyGraph>();
-  AU.addRequired<ControlDependencyGraph>();
+  AU.addRequired<PostDominatorTreeWrapperPass>();
   AU.setPreservesAll();
 }
 
 bool pdg::ProgramDependencyGraph::runOnModule(Module &M)
+{
+  auto &graph_wrapper = getAnalysis<ProgramGraphWrapperPass>();
+  buildPDG(M, graph_wrapper.getPDG(), graph_wrapper.getMemReport(), [this](Function &F) -> PostDominatorTree & { return getAnalysis<PostDominatorTreeWrapperPass>(F).getPostDomTree(); });
+  return false;
+}
+
+void pdg::ProgramDependencyGraph::buildPDG(Module &M, ProgramGraph &g, MemoryReport &mem_report, std::function<PostDominatorTree &(Function &)> get_pdt)
 {
   auto start = std::chrono::high_resolution_clock::now();
   _module = &M;
-  _PDG = &ProgramGraph::getInstance();
+  _PDG = &g;
+  _get_pdt = std::move(get_pdt);
+  initializer_map.clear();
 
-  // PDGCallGraph &call_g = PDGCallGraph::getInstance();
+  // PDGCallGraph call_g;
   // if (!call_g.isBuild())
   //   call_g.build(M);
 
@@ -52,7 +66,7 @@ bool pdg::ProgramDependencyGraph::runOnModule(Module &M)
   connectGlobalWithUses();
   for (auto &F : M)
   {
-    if (F.isDeclaration())
+    if (F.isDeclaration() || !_PDG->hasFuncWrapper(F))
       continue;
     connectIntraprocDependencies(F);
     connectInterprocDependencies(F);
@@ -64,11 +78,20 @@ bool pdg::ProgramDependencyGraph::runOnModule(Module &M)
   auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
   // errs() << "building PDG takes: " <<  duration.count() << "\n";
   // errs() << "PDG Node size: " << _PDG->numNode() << "\n";
+  if (MEMREPORT)
+    mem_report.recordPhase("pdg", *_PDG);
+  _PDG->freeze();
+  if (MEMREPORT)
+  {
+    mem_report.recordPhase("freeze", *_PDG);
+    mem_report.computeFootprint(*_PDG);
+    mem_report.print(errs());
+    if (mem_report.writeJSONFile("pdg_mem_report.json"))
+      errs() << "exported pdg_mem_report.json\n";
+  }
 
   if (DEBUG)
     _PDG->dumpGraph();
-
-  return false;
 }
 
 void pdg::ProgramDependencyGraph::populateInitializerMap()
@@ -131,11 +154,10 @@ void pdg::ProgramDependencyGraph::connectInTrees(Tree* src_tree, Tree* dst_tree,
     TreeNode* dst = current_node_pair.second;
     assert(src->numOfChild() == dst->numOfChild());
     src->addNeighbor(*dst, edge_type);
-    auto src_node_children = src->getChildNodes();
-    auto dst_node_children = dst->getChildNodes();
-    for (int i = 0; i < src->numOfChild(); i++)
+    auto dst_child_iter = dst->getChildNodes().begin();
+    for (auto src_child : src->getChildNodes())
     {
-      node_pairs_queue.push(std::make_pair(src_node_children[i], dst_node_children[i]));
+      node_pairs_queue.push(std::make_pair(src_child, *dst_child_iter++));
     }
   }
 }
@@ -157,59 +179,14 @@ void pdg::ProgramDependencyGraph::connectOutTrees(Tree* src_tree, Tree* dst_tree
     assert(src->numOfChild() == dst->numOfChild());
     if (src->hasWriteAccess())
       src->addNeighbor(*dst, edge_type);
-    auto src_node_children = src->getChildNodes();
-    auto dst_node_children = dst->getChildNodes();
-    for (int i = 0; i < src->numOfChild(); i++)
+    auto dst_child_iter = dst->getChildNodes().begin();
+    for (auto src_child : src->getChildNodes())
     {
-      node_pairs_queue.push(std::make_pair(src_node_children[i], dst_node_children[i]));
+      node_pairs_queue.push(std::make_pair(src_child, *dst_child_iter++));
     }
   }
 }
 
-bool pdg::ProgramDependencyGraph::isFuncSignatureMatch(llvm::CallInst &ci, llvm::Function &f)
-{
-  if (f.isVarArg())
-    return false;
-  auto actual_arg_list_size = ci.arg_size();
-  auto formal_arg_list_size = f.arg_size();
-  if (actual_arg_list_size != formal_arg_list_size)
-    return false;
-  // compare return type
-  auto actual_ret_type = ci.getType();
-  auto formal_ret_type = f.getReturnType();
-  if (!isTypeEqual(*actual_ret_type, *formal_ret_type))
-    return false;
-  
-  for (unsigned i = 0; i < actual_arg_list_size; i++)
-  {
-    auto actual_arg = ci.getOperand(i);
-    auto formal_arg = f.getArg(i);
-    if (!isTypeEqual(*actual_arg->getType(), *formal_arg->getType()))
-      return false;
-  }
-  return true;
-}
-
-bool pdg::ProgramDependencyGraph::isTypeEqual(llvm::Type& t1, llvm::Type &t2)
-{
-  if (&t1 == &t2)
-    return true;
-  // need to compare name for sturct, due to llvm-link duplicate struct types
-  if (!t1.isPointerTy() || !t2.isPointerTy())
-    return false;
-
-  auto t1_pointed_ty = t1.getPointerElementType();
-  auto t2_pointed_ty = t2.getPointerElementType();
-
-  if (!t1_pointed_ty->isStructTy() || !t2_pointed_ty->isStructTy())
-    return false;
-  
-  auto t1_name = pdgutils::stripVersionTag(t1_pointed_ty->getStructName().str());
-  auto t2_name = pdgutils::stripVersionTag(t2_pointed_ty->getStructName().str());
-
-  return (t1_name == t2_name);
-}
-
 void pdg::ProgramDependencyGraph::argPassEdges(CallWrapper& cw, EdgeType in_edge, EdgeType out_edge)
 {
   auto& ci = *cw.getCallInst();
@@ -243,54 +220,45 @@ void pdg::ProgramDependencyGraph::argPassEdges(CallWrapper& cw, EdgeType in_edge
 void pdg::ProgramDependencyGraph::connectCallerIndirect(llvm::CallInst &ci)
 {
   auto callSiteNode = _PDG->getNode(ci);
-  for (auto &func : *_module)
+  for (auto func : _PDG->getFuncSignatureIndex().getCandidates(ci))
   {
-    auto potentialCallee = _PDG->getNode(func);
-    if(potentialCallee)
+    // only functions in the graph with a use that is in the graph too
+    auto potentialCallee = _PDG->getNode(*func);
+    if (potentialCallee == nullptr || llvm::none_of(func->users(), [this](User *user) { return _PDG->hasNode(*user); }))
+      continue;
+    callSiteNode->addNeighbor(*potentialCallee, EdgeType::IND_CALL);
+    if(auto fw = getFuncWrapper(*func))
     {
-      auto hasUse = false; 
-      for(auto user : func.users())
+      CallWrapper cw(ci);
+      cw.buildActualTreeForArgs(*fw);
+      cw.buildActualTreesForRetVal(*fw);
+      argPassEdges(cw, EdgeType::DATA_ARGPASS_INDIRECT_IN, EdgeType::DATA_ARGPASS_INDIRECT_OUT);
+
+      for(auto arg : cw.getArgList())
       {
-        if(_PDG->hasNode(*user))
-          hasUse = true;
+        auto in_tree = cw.getArgActualInTree(*arg);
+        auto out_tree = cw.getArgActualOutTree(*arg);
+        TreeNode* root_in = nullptr;
+        TreeNode* root_out = nullptr;
+        if(in_tree)
+          root_in = in_tree->getRootNode();
+        if(out_tree)
+          root_out = out_tree->getRootNode();
+        if(root_in)
+          _PDG->addNode(*root_in);
+        if(root_out)
+          _PDG->addNode(*root_out);
+
+        if(!(root_in && root_out))
+          errs() << "WARNING: Could not connect indirect argpass edges" << "\n";
       }
-      if(isFuncSignatureMatch(ci, func) && hasUse)
-      {
-        callSiteNode->addNeighbor(*potentialCallee, EdgeType::IND_CALL);
-        if(auto fw = getFuncWrapper(func))
-        {
-          CallWrapper cw(ci);
-          cw.buildActualTreeForArgs(*fw);
-          cw.buildActualTreesForRetVal(*fw);
-          argPassEdges(cw, EdgeType::DATA_ARGPASS_INDIRECT_IN, EdgeType::DATA_ARGPASS_INDIRECT_OUT);
-
-          for(auto arg : cw.getArgList())
-          {
-            auto in_tree = cw.getArgActualInTree(*arg);
-            auto out_tree = cw.getArgActualOutTree(*arg);
-            TreeNode* root_in = nullptr;
-            TreeNode* root_out = nullptr;
-            if(in_tree)
-              root_in = in_tree->getRootNode();
-            if(out_tree)
-              root_out = out_tree->getRootNode();
-            if(root_in)
-              _PDG->addNode(*root_in);
-            if(root_out)
-              _PDG->addNode(*root_out);
-
-            if(!(root_in && root_out))
-              errs() << "WARNING: Could not connect indirect argpass edges" << "\n";
-          }
 
-          for(auto ret : fw->getReturnInsts())
-          {
-            Node *src = _PDG->getNode(*ret);
-            if (src == nullptr)
-              continue;
-            src->addNeighbor(*potentialCallee, EdgeType::DATA_INDIRECT_RET);
-          }
-        }
+      for(auto ret : fw->getReturnInsts())
+      {
+        Node *src = _PDG->getNode(*ret);
+        if (src == nullptr)
+          continue;
+        src->addNeighbor(*potentialCallee, EdgeType::DATA_INDIRECT_RET);
       }
     }
   }
@@ -375,7 +343,8 @@ void pdg::ProgramDependencyGraph::connectCallerAndCallee(CallWrapper &cw, Functi
 void pdg::ProgramDependencyGraph::connectIntraprocDependencies(Function &F)
 {
   // add control dependency edges
-  getAnalysis<ControlDependencyGraph>(F); // add control dependencies for nodes in F
+  auto &PDT = _get_pdt(F);
+  _cdg.computeControlDependencies(F, *_PDG, PDT); // add control dependencies for nodes in F
   // connect formal tree with address variables
   FunctionWrapper* func_w = getFuncWrapper(F);
   Node* entry_node = func_w->getEntryNode();
@@ -460,7 +429,7 @@ void pdg::ProgramDependencyGraph::connectFormalInTreeWithAddrVars(Tree &formal_i
     TreeNode* current_node = node_queue.front();
     node_queue.pop();
     TreeNode* parent_node = current_node->getParentNode();
-    std::unordered_set<Value*> parent_node_addr_vars;
+    ArrayRef<Value*> parent_node_addr_vars;
     if (parent_node != nullptr)
       parent_node_addr_vars = parent_node->getAddrVars();
     for (auto addr_var : current_node->getAddrVars())
@@ -475,7 +444,7 @@ void pdg::ProgramDependencyGraph::connectFormalInTreeWithAddrVars(Tree &formal_i
         Value* alias_node_val = alias_node->getValue();
         if (alias_node_val == nullptr)
           continue;
-        if (parent_node_addr_vars.find(alias_node_val) != parent_node_addr_vars.end())
+        if (is_contained(parent_node_addr_vars, alias_node_val))
           continue;
         current_node->addNeighbor(*alias_node, EdgeType::PARAMETER_IN);
       }
@@ -520,7 +489,8 @@ void pdg::ProgramDependencyGraph::connectFormalOutTreeWithAddrVars(Tree &formal_
 void pdg::ProgramDependencyGraph::connectActualTreeWithAddrVars(Tree &actual_in_tree, CallInst &ci, EdgeType type, bool use_before_only)
 {
   TreeNode *root_node = actual_in_tree.getRootNode();
-  std::set<Instruction*> insts_before_after_ci = pdgutils::getInstructionBeforeInst(ci);
+  auto caller_w = getFuncWrapper(*ci.getFunction());
+  int ci_ordinal = caller_w->getInstOrdinal(ci);
   std::queue<TreeNode *> node_queue;
   node_queue.push(root_node);
   while (!node_queue.empty())
@@ -534,7 +504,8 @@ void pdg::ProgramDependencyGraph::connectActualTreeWithAddrVars(Tree &actual_in_
       {
         if (Instruction *i = dyn_cast<Instruction>(addr_var))
         {
-          if (insts_before_after_ci.find(i) == insts_before_after_ci.end())
+          int i_ordinal = caller_w->getInstOrdinal(*i);
+          if (i_ordinal < 0 || i_ordinal >= ci_ordinal)
             continue;
         }
       }
@@ -551,5 +522,18 @@ void pdg::ProgramDependencyGraph::connectActualTreeWithAddrVars(Tree &actual_in_
   }
 }
 
+PreservedAnalyses pdg::ProgramDependencyGraphPass::run(Module &M, ModuleAnalysisManager &MAM)
+{
+  auto &graph_res = MAM.getResult<ProgramGraphAnalysis>(M);
+  if (graph_res.has_pdg)
+    return PreservedAnalyses::all();
+  DataDependencyGraphPass().run(M, MAM);
+  auto &FAM = MAM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+  ProgramDependencyGraph pdg;
+  pdg.buildPDG(M, *graph_res.graph, *graph_res.mem_report, [&FAM](Function &F) -> PostDominatorTree & { return FAM.getResult<PostDominatorTreeAnalysis>(F); });
+  graph_res.has_pdg = true;
+  return PreservedAnalyses::all();
+}
+
 static RegisterPass<pdg::ProgramDependencyGraph>
     PDG("pdg", "Program Dependency Graph Construction", false, true);
\ No newline at end of file
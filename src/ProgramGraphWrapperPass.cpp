@@ -0,0 +1,59 @@
+#include "ProgramGraphWrapperPass.hh"
+
+using namespace llvm;
+
+char pdg::ProgramGraphWrapperPass::ID = 0;
+
+pdg::ProgramGraphWrapperPass::ProgramGraphWrapperPass() : ImmutablePass(ID)
+{
+  _PDG = nullptr;
+}
+
+pdg::ProgramGraphWrapperPass::ProgramGraphWrapperPass(ProgramGraph &g) : ImmutablePass(ID)
+{
+  _PDG = &g;
+}
+
+bool pdg::ProgramGraphWrapperPass::doInitialization(Module &M)
+{
+  if (_PDG == nullptr)
+  {
+    _owned_graph = std::make_unique<ProgramGraph>();
+    _PDG = _owned_graph.get();
+  }
+  // drop whatever is left from the previous module
+  _PDG->clear();
+  _mem_report.clear();
+  return false;
+}
+
+bool pdg::ProgramGraphWrapperPass::doFinalization(Module &M)
+{
+  // a caller provided graph stays alive until the caller clears it
+  if (_owned_graph)
+  {
+    _owned_graph.reset();
+    _PDG = nullptr;
+  }
+  return false;
+}
+
+AnalysisKey pdg::ProgramGraphAnalysis::Key;
+
+pdg::ProgramGraphAnalysis::Result pdg::ProgramGraphAnalysis::run(Module &M, ModuleAnalysisManager &MAM)
+{
+  Result res;
+  res.graph = std::make_unique<ProgramGraph>();
+  res.mem_report = std::make_unique<MemoryReport>();
+  return res;
+}
+
+bool pdg::ProgramGraphAnalysis::Result::invalidate(Module &M, const PreservedAnalyses &PA, ModuleAnalysisManager::Invalidator &inv)
+{
+  // the graph points into the IR, any pass that changes the module drops it
+  auto checker = PA.getChecker<ProgramGraphAnalysis>();
+  return !checker.preserved() && !checker.preservedSet<AllAnalysesOn<Module>>();
+}
+
+static RegisterPass<pdg::ProgramGraphWrapperPass>
+    PGW("pdg-graph", "Program Graph Storage", false, true);
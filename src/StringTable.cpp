@@ -0,0 +1,45 @@
+#include "StringTable.hh"
+
+using namespace llvm;
+
+void pdg::StringTable::clear()
+{
+  _string_ids.clear();
+  _strings.clear();
+  _file_path_ids.clear();
+  // keep in sync with the reserved handles
+  intern("None");
+  intern("Not Found");
+  intern("");
+}
+
+size_t pdg::StringTable::getMemoryUsage() const
+{
+  size_t bytes = _strings.capacity() * sizeof(StringRef);
+  bytes += _string_ids.getNumBuckets() * (sizeof(void *) + sizeof(unsigned));
+  for (auto &entry : _string_ids)
+    bytes += sizeof(entry) + entry.getKeyLength() + 1;
+  bytes += _file_path_ids.getMemorySize();
+  return bytes;
+}
+
+unsigned pdg::StringTable::intern(StringRef str)
+{
+  auto insert_res = _string_ids.try_emplace(str, _strings.size());
+  // the key is owned by the map entry, which does not move on rehash
+  if (insert_res.second)
+    _strings.push_back(insert_res.first->getKey());
+  return insert_res.first->getValue();
+}
+
+unsigned pdg::StringTable::internFilePath(DIFile *file)
+{
+  if (file == nullptr)
+    return intern("/");
+  auto iter = _file_path_ids.find(file);
+  if (iter != _file_path_ids.end())
+    return iter->second;
+  unsigned id = intern((file->getDirectory() + "/" + file->getFilename()).str());
+  _file_path_ids.insert(std::make_pair(file, id));
+  return id;
+}
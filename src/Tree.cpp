@@ -2,127 +2,196 @@
 
 using namespace llvm;
 
-pdg::TreeNode::TreeNode(const TreeNode &tree_node) : Node(tree_node.getNodeType())
+pdg::TreeNode::TreeNode(const TreeNode &tree_node, Tree *tree) : Node(*tree_node._arena, tree_node.getNodeType())
 {
   _func = tree_node.getFunc();
   _node_di_type = tree_node.getDIType();
   _node_type = tree_node.getNodeType();
+  _tree = tree;
 }
 
-pdg::TreeNode::TreeNode(DIType *di_type, int depth, TreeNode *parent_node, Tree *tree, GraphNodeType node_type) : Node(node_type)
+pdg::TreeNode::TreeNode(GraphArena &arena, DIType *di_type, Tree *tree, unsigned shape_idx, GraphNodeType node_type) : Node(arena, node_type)
 {
   _node_di_type = di_type;
-  _depth = depth;
-  _parent_node = parent_node;
   _tree = tree;
-  // errs() << "Made tree node at arrs: " << this << "\n";
-  // errs() << "Parent tree node at adrs: " << _parent_node << "\n";
+  _shape_idx = shape_idx;
 }
 
-pdg::TreeNode::TreeNode(Function &f, DIType *di_type, int depth, TreeNode *parent_node, Tree *tree, GraphNodeType node_type) : Node(node_type)
+pdg::TreeNode::TreeNode(GraphArena &arena, Function &f, DIType *di_type, Tree *tree, unsigned shape_idx, GraphNodeType node_type) : Node(arena, node_type)
 {
   _node_di_type = di_type;
-  _depth = depth;
-  _parent_node = parent_node;
   _tree = tree;
+  _shape_idx = shape_idx;
   _func = &f;
-  // errs() << "Made tree node at adrs: " << this << "\n";
-  // errs() << "Parent tree node at adrs: " << _parent_node << "\n";
 }
 
-int pdg::TreeNode::expandNode()
+size_t pdg::TreeNode::getMemoryUsage() const
 {
-  // expand debugging information here
-  if (_node_di_type == nullptr)
-    return 0;
-  DIType* dt = dbgutils::stripAttributes(*_node_di_type);
-  dt = dbgutils::stripMemberTag(*dt);
-  // iterate through all the child nodes, build a tree node for each of them.
-  if (!dbgutils::isPointerType(*dt) && !dbgutils::isStructType(*dt))
+  // the per node state is in the side tables of the tree, see Tree::getMemoryUsage
+  return Node::getMemoryUsage() - sizeof(Node) + sizeof(TreeNode);
+}
+
+llvm::DILocalVariable *pdg::TreeNode::getDILocalVar()
+{
+  return isRootNode() ? _tree->getDILocalVar() : nullptr;
+}
+
+void pdg::TreeNode::setDILocalVariable(DILocalVariable &di_local_var)
+{
+  assert(isRootNode() && "only the root of a tree has a local variable");
+  _tree->setDILocalVar(di_local_var);
+}
+
+void pdg::TreeNode::addAddrVar(Value &v)
+{
+  _tree->addAddrVar(_shape_idx, v);
+}
+
+pdg::TreeNodeRange pdg::TreeNode::getChildNodes()
+{
+  return _tree->getChildNodes(_shape_idx);
+}
+
+int pdg::TreeNode::numOfChild()
+{
+  auto children = getChildNodes();
+  return std::distance(children.begin(), children.end());
+}
+
+ArrayRef<Value *> pdg::TreeNode::getAddrVars()
+{
+  return _tree->getAddrVars(_shape_idx);
+}
+
+pdg::TreeNode *pdg::TreeNode::getParentNode()
+{
+  if (isRootNode())
+    return nullptr;
+  return _tree->getNode(_tree->getShape()->getNodes()[_shape_idx].parent);
+}
+
+int pdg::TreeNode::getDepth()
+{
+  if (isRootNode())
     return 0;
+  return _tree->getShape()->getNodes()[_shape_idx].depth;
+}
 
-  if (dbgutils::isPointerType(*dt))
-  {
-    DIType* pointed_obj_dt = dbgutils::getLowestDIType(*dt);
-    TreeNode* parentNode = this;
-    // errs() << "Address of this node: " << parentNode << "\n";
-    TreeNode *new_child_node = new TreeNode(*_func, pointed_obj_dt, _depth + 1, parentNode, _tree, getNodeType());
-    new_child_node->computeDerivedAddrVarsFromParent();
-    _children.push_back(new_child_node);
-    this->addNeighbor(*new_child_node, EdgeType::PARAMETER_FIELD);
-    return 1;
-  }
-  // TODO: should change to aggregate type later
-  if (dbgutils::isStructType(*dt))
+void pdg::TreeNode::addAccessTag(AccessTag acc_tag)
+{
+  _tree->addAccessTag(_shape_idx, acc_tag);
+}
+
+bool pdg::TreeNode::hasReadAccess()
+{
+  return _tree->hasAccessTag(_shape_idx, AccessTag::DATA_READ);
+}
+
+bool pdg::TreeNode::hasWriteAccess()
+{
+  return _tree->hasAccessTag(_shape_idx, AccessTag::DATA_WRITE);
+}
+
+//  ====== Tree =======
+pdg::Tree::Tree(const Tree &src_tree)
+{
+  TreeNode *src_tree_root_node = src_tree.getRootNode();
+  setRootNode(*src_tree_root_node->getArena().create<TreeNode>(*src_tree_root_node, this));
+  _size = 0;
+}
+
+void pdg::Tree::setRootNode(TreeNode &root_node)
+{
+  assert(root_node.getTree() == this && root_node.isRootNode() && "root node of another tree");
+  _root_node = &root_node;
+  _nodes.assign(1, &root_node);
+  _addr_var_offsets.assign(1, 0);
+  _addr_vars.clear();
+  _acc_tags.assign(1, 0);
+}
+
+static bool isBuiltTreeNode(pdg::TreeNode *n)
+{
+  return n != nullptr;
+}
+
+pdg::TreeNodeRange pdg::Tree::getChildNodes(unsigned shape_idx) const
+{
+  TreeNode *const *begin = _nodes.data();
+  TreeNode *const *end = begin;
+  if (_shape != nullptr)
   {
-    auto di_node_arr = dyn_cast<DICompositeType>(dt)->getElements();
-    for (unsigned i = 0; i < di_node_arr.size(); i++)
-    {
-      DIType *field_di_type = dyn_cast<DIType>(di_node_arr[i]);
-      TreeNode* parentNode = this;
-      TreeNode *new_child_node = new TreeNode(*_func, field_di_type, _depth + 1, parentNode, _tree, getNodeType());
-      new_child_node->computeDerivedAddrVarsFromParent();
-      _children.push_back(new_child_node);
-      this->addNeighbor(*new_child_node, EdgeType::PARAMETER_FIELD);
-    }
-    return di_node_arr.size();
+    auto &shape_node = _shape->getNodes()[shape_idx];
+    begin += shape_node.first_child;
+    end = begin + shape_node.num_children;
   }
+  return make_filter_range(make_range(begin, end), isBuiltTreeNode);
+}
 
-  return 0;
+ArrayRef<Value *> pdg::Tree::getAddrVars(unsigned shape_idx) const
+{
+  unsigned begin = _addr_var_offsets[shape_idx];
+  unsigned end = shape_idx + 1 < _addr_var_offsets.size() ? _addr_var_offsets[shape_idx + 1] : _addr_vars.size();
+  return makeArrayRef(_addr_vars).slice(begin, end - begin);
 }
 
-void pdg::TreeNode::computeDerivedAddrVarsFromParent()
+void pdg::Tree::addAddrVar(unsigned shape_idx, Value &v)
 {
-  if (!_parent_node)
-    return;
-  if (!_node_di_type)
+  assert(shape_idx + 1 == _addr_var_offsets.size() && "addr vars of a packed tree node");
+  if (!is_contained(getAddrVars(shape_idx), &v))
+    _addr_vars.push_back(&v);
+}
+
+size_t pdg::Tree::getMemoryUsage() const
+{
+  return sizeof(Tree) + _nodes.capacity() * sizeof(TreeNode *) + _addr_var_offsets.capacity() * sizeof(unsigned) +
+         _addr_vars.capacity() * sizeof(Value *) + _acc_tags.capacity();
+}
+
+// the loads and geps of the parent's addr vars that access this node. A field of a struct
+// reached through a pointer takes them from the pointer, the grand parent
+void pdg::Tree::computeDerivedAddrVars(unsigned shape_idx)
+{
+  auto &shape_nodes = _shape->getNodes();
+  DIType *node_di_type = shape_nodes[shape_idx].di_type;
+  if (!node_di_type)
     return;
-  std::unordered_set<llvm::Value *> base_node_addr_vars;
-  // handle struct pointer
-  TreeNode* grand_parent_node = _parent_node->getParentNode();
+  int parent_idx = shape_nodes[shape_idx].parent;
+  int grand_parent_idx = shape_nodes[parent_idx].parent;
+  DIType *parent_di_type = shape_nodes[parent_idx].di_type;
   // TODO: now handle struct specifically, but should also verify on other aggregate pointer types
-  // errs() << "Parent Node: " <<  _parent_node << "\n";
-  // errs() << "Grand Parent Node: " <<  grand_parent_node << "\n";
-  if (_parent_node != nullptr && grand_parent_node != nullptr && _parent_node->getDIType() != nullptr && grand_parent_node->getDIType() != nullptr && dbgutils::isStructType(*_parent_node->getDIType()) && dbgutils::isStructPointerType(*grand_parent_node->getDIType()))
-  {
-    base_node_addr_vars = grand_parent_node->getAddrVars();
-  }
-  else
-    base_node_addr_vars = _parent_node->getAddrVars();
+  int base_idx = parent_idx;
+  if (grand_parent_idx >= 0 && parent_di_type != nullptr && shape_nodes[grand_parent_idx].di_type != nullptr && dbgutils::isStructType(*parent_di_type) && dbgutils::isStructPointerType(*shape_nodes[grand_parent_idx].di_type))
+    base_idx = grand_parent_idx;
 
   bool is_struct_field = false;
-  if (dbgutils::isStructType(*_parent_node->getDIType()))
+  if (parent_di_type != nullptr && dbgutils::isStructType(*parent_di_type))
     is_struct_field = true;
 
-  for (auto base_node_addr_var : base_node_addr_vars)
+  // the base slice is read by index, appending to _addr_vars may move it
+  unsigned base_begin = _addr_var_offsets[base_idx];
+  unsigned base_end = _addr_var_offsets[base_idx + 1];
+  SmallPtrSet<Value *, 16> derived;
+  for (unsigned i = base_begin; i < base_end; i++)
   {
-    for (auto user : base_node_addr_var->users())
+    for (auto user : _addr_vars[i]->users())
     {
       // handle load instruction, field should not get the load inst from the sturct pointer.
       if (LoadInst *li = dyn_cast<LoadInst>(user))
       {
-        if (!is_struct_field)
-          _addr_vars.insert(li);
+        if (!is_struct_field && derived.insert(li).second)
+          _addr_vars.push_back(li);
       }
       // handle gep instruction
       if (GetElementPtrInst *gep = dyn_cast<GetElementPtrInst>(user))
       {
-        if (pdgutils::isGEPOffsetMatchDIOffset(*_node_di_type, *gep))
-          _addr_vars.insert(gep);
+        if (pdgutils::isGEPOffsetMatchDIOffset(*node_di_type, *gep) && derived.insert(gep).second)
+          _addr_vars.push_back(gep);
       }
     }
   }
 }
 
-//  ====== Tree =======
-pdg::Tree::Tree(const Tree &src_tree)
-{
-  TreeNode *src_tree_root_node = src_tree.getRootNode();
-  TreeNode *new_root_node = new TreeNode(*src_tree_root_node);
-  _root_node = new_root_node;
-  _size = 0;
-}
-
 void pdg::Tree::print()
 {
   std::queue<TreeNode *> node_queue;
@@ -154,28 +223,30 @@ void pdg::Tree::print()
 
 void pdg::Tree::build(int max_tree_depth)
 {
-  int current_tree_depth = 0;
-  std::queue<TreeNode *> node_queue;
-  node_queue.push(_root_node);
-  while (!node_queue.empty()) // have more child to expand
+  // the shape gives the layout, only the per tree state (node ids, addr vars, access tags) is
+  // computed here, one entry per shape entry
+  _shape = &_root_node->getArena().getTreeShapes().getShape(_root_node->getDIType(), max_tree_depth);
+  auto &shape_nodes = _shape->getNodes();
+  _nodes.reserve(shape_nodes.size());
+  _addr_var_offsets.reserve(shape_nodes.size());
+  _acc_tags.resize(shape_nodes.size(), 0);
+  GraphArena &arena = _root_node->getArena();
+  for (size_t i = 1; i < shape_nodes.size(); i++)
   {
-    current_tree_depth++;
-    if (current_tree_depth > max_tree_depth)
-      break;
-    int queue_size = node_queue.size();
-    while (queue_size > 0)
+    _addr_var_offsets.push_back(_addr_vars.size());
+    TreeNode *parent_node = _nodes[shape_nodes[i].parent];
+    if (shape_nodes[i].fold_target >= 0)
     {
-      queue_size--;
-      TreeNode *current_node = node_queue.front();
-      node_queue.pop();
-      _size++;
-      if (current_node->expandNode() > 0)
-      {
-        for (auto child_node : current_node->getChildNodes())
-        {
-          node_queue.push(child_node);
-        }
-      }
+      parent_node->addNeighbor(*_nodes[shape_nodes[i].fold_target], EdgeType::PARAMETER_FIELD);
+      _nodes.push_back(nullptr);
+      continue;
     }
+    TreeNode *child_node = arena.create<TreeNode>(arena, *parent_node->getFunc(), shape_nodes[i].di_type, this, i, parent_node->getNodeType());
+    _nodes.push_back(child_node);
+    computeDerivedAddrVars(i);
+    parent_node->addNeighbor(*child_node, EdgeType::PARAMETER_FIELD);
   }
-}
\ No newline at end of file
+  _addr_var_offsets.push_back(_addr_vars.size());
+  _addr_vars.shrink_to_fit();
+  _size += _shape->getExpandedSize();
+}
@@ -0,0 +1,82 @@
+#include "TreeShape.hh"
+#include "DebugInfoUtils.hh"
+#include "PDGCommandLineOptions.hh"
+
+using namespace llvm;
+
+unsigned pdg::TREEDEPTH;
+
+cl::opt<unsigned, true> TREEDEPTH("pdg-tree-depth", cl::desc("maximum depth of parameter trees, 0 for no limit (recursive types are folded either way)"), cl::location(pdg::TREEDEPTH), cl::init(0));
+
+unsigned pdg::TREETYPEBUDGET;
+
+cl::opt<unsigned, true> TREETYPEBUDGET("pdg-tree-type-budget", cl::desc("number of times one struct type is expanded in a parameter tree, 0 for no limit"), cl::location(pdg::TREETYPEBUDGET), cl::init(4));
+
+pdg::TreeShape::TreeShape(DITypeCache &di_types, DIType *root_di_type, int max_tree_depth, unsigned type_budget)
+{
+  _nodes.push_back({root_di_type, -1, -1, 0, 0, 0});
+  DenseMap<DIType *, unsigned> struct_expansions;
+  // expand level by level
+  size_t level_begin = 0;
+  for (int depth = 0; level_begin < _nodes.size(); depth++)
+  {
+    size_t level_end = _nodes.size();
+    for (size_t i = level_begin; i < level_end; i++)
+    {
+      if (_nodes[i].fold_target >= 0)
+        continue;
+      _max_depth = depth;
+      DIType *di_type = _nodes[i].di_type;
+      if (max_tree_depth > 0 && depth >= max_tree_depth)
+        continue;
+      auto &child_di_types = di_types.getChildTypes(di_type);
+      _expanded_size++;
+      DIType *canonical_type = di_types.getCanonicalType(di_type);
+      if (type_budget > 0 && canonical_type != nullptr && dbgutils::isStructType(*canonical_type) && struct_expansions[canonical_type]++ >= type_budget)
+      {
+        _num_budget_cut += !child_di_types.empty();
+        continue;
+      }
+      _nodes[i].first_child = _nodes.size();
+      _nodes[i].num_children = child_di_types.size();
+      for (auto child_di_type : child_di_types)
+      {
+        int fold_target = findFoldTarget(di_types, i, child_di_type);
+        _num_folded += fold_target >= 0;
+        _nodes.push_back({child_di_type, static_cast<int>(i), fold_target, depth + 1, 0, 0});
+      }
+    }
+    level_begin = level_end;
+  }
+}
+
+// the closest node on the path from node_idx to the root that is a struct of the same type as
+// child_di_type, -1 if there is none
+int pdg::TreeShape::findFoldTarget(DITypeCache &di_types, int node_idx, DIType *child_di_type) const
+{
+  DIType *child_type = di_types.getCanonicalType(child_di_type);
+  if (child_type == nullptr || !dbgutils::isStructType(*child_type))
+    return -1;
+  for (int ancestor = node_idx; ancestor >= 0; ancestor = _nodes[ancestor].parent)
+  {
+    if (di_types.getCanonicalType(_nodes[ancestor].di_type) == child_type)
+      return ancestor;
+  }
+  return -1;
+}
+
+const pdg::TreeShape &pdg::TreeShapeCache::getShape(DIType *root_di_type, int max_tree_depth)
+{
+  auto &shape = _shapes[std::make_pair(root_di_type, max_tree_depth)];
+  if (!shape)
+    shape = std::make_unique<TreeShape>(_di_types, root_di_type, max_tree_depth, TREETYPEBUDGET);
+  return *shape;
+}
+
+size_t pdg::TreeShapeCache::getMemoryUsage() const
+{
+  size_t bytes = _shapes.getMemorySize();
+  for (auto &pair : _shapes)
+    bytes += pair.second->getMemoryUsage();
+  return bytes;
+}
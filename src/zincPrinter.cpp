@@ -103,20 +103,35 @@ std::map<pdg::GraphNodeType, std::vector<pdg::Node *>> pdg::MiniZincPrinter::nod
   return map;
 }
 
-std::map<pdg::EdgeType, std::vector<pdg::Edge *>> pdg::MiniZincPrinter::edgesByEdgeType(pdg::ProgramGraph &PDG)
+std::map<pdg::EdgeType, std::vector<pdg::Edge *>> pdg::MiniZincPrinter::edgesByEdgeType(pdg::ProgramGraph &PDG, std::deque<pdg::Edge> &range_edges)
 {
   std::map<pdg::EdgeType, std::vector<pdg::Edge *>> map;
+  // retype through the graph before freezing, so that the snapshot and the exported edges agree
   for(auto node : PDG)
   {
-    for(auto edge : *node)
+    for(auto edge : node->getOutEdges())
     {
       // similarly found in original exporter: why was it needed? 
-      if(edge->getSrcNode()->getNodeType() == GraphNodeType::ANNO_VAR 
+      if(node->getNodeType() == GraphNodeType::ANNO_VAR 
       || edge->getDstNode()->getNodeType() == GraphNodeType::ANNO_VAR) 
       {
-        edge->setEdgeType(EdgeType::ANNO_VAR);
+        PDG.setEdgeType(*edge, EdgeType::ANNO_VAR);
       }
-
+    }
+  }
+  // the control edges recorded per block come from branches and function entries, only their
+  // dst can be an annotation
+  PDG.setBlockControlDepType(GraphNodeType::ANNO_VAR, EdgeType::ANNO_VAR);
+  if (!PDG.isFrozen())
+    PDG.freeze();
+  auto &frozen = PDG.getFrozenGraph();
+  unsigned rangeEdgeId = PDG.getArena().numEdgeIDs();
+  for(unsigned i = 0; i < frozen.numGraphNodes(); i++)
+  {
+    auto outEdgeObjects = frozen.getOutEdgeObjects(i);
+    for(size_t k = 0; k < outEdgeObjects.size(); k++)
+    {
+      auto edge = outEdgeObjects[k];
       auto edgeType = edge->getEdgeType(); 
 
       if(map.find(edgeType) == map.end()) 
@@ -124,15 +139,24 @@ std::map<pdg::EdgeType, std::vector<pdg::Edge *>> pdg::MiniZincPrinter::edgesByE
 
       map[edgeType].push_back(edge);
     }
+    // the edges without objects, expanded in record order
+    for(auto &range : frozen.getOutRangeEdges(i))
+    {
+      for(unsigned k = range.first; k < range.first + range.count; k++)
+      {
+        range_edges.emplace_back(frozen.getNode(i), frozen.getNode(k), range.edge_type, rangeEdgeId++);
+        map[range.edge_type].push_back(&range_edges.back());
+      }
+    }
   }
   return map;
 }
 
 template<typename A, typename B>
-pdg::RangesAndIds<A, B> pdg::MiniZincPrinter::toRangesAndIds(std::map<A, std::vector<B>> groupedByA, std::function<unsigned int(B)> getId)
+pdg::RangesAndIds<A, B> pdg::MiniZincPrinter::toRangesAndIds(std::map<A, std::vector<B>> groupedByA, std::function<unsigned int(B)> getId, size_t numIds)
 {
   std::map<A, std::pair<size_t, size_t>> ranges;
-  std::map<unsigned int, size_t> ids;
+  std::vector<size_t> ids(numIds, 0);
   std::vector<B> ordered;
   size_t index = 0;
   for(auto pair : groupedByA) 
@@ -153,15 +177,16 @@ pdg::RangesAndIds<A, B> pdg::MiniZincPrinter::toRangesAndIds(std::map<A, std::ve
 }
 
 
-std::map<unsigned int, unsigned int> pdg::MiniZincPrinter::hasFn(pdg::ProgramGraph &PDG)
+std::vector<std::optional<unsigned int>> pdg::MiniZincPrinter::hasFn(pdg::ProgramGraph &PDG)
 {
-  std::map<unsigned int, unsigned int> result; 
+  std::vector<std::optional<unsigned int>> result(PDG.getArena().numNodeIDs());
   for(auto node : PDG)
   {
     auto fn = node->getFunc();
-    if(fn) 
+    // a function scope static may belong to a function without a body, e.g. after pdg -lazy
+    if(fn && PDG.hasFuncWrapper(*fn)) 
     {
-      auto fnNode = PDG.getFuncWrapperMap()[fn]->getEntryNode();
+      auto fnNode = PDG.getFuncWrapper(*fn)->getEntryNode();
       if(fnNode)
         result[node->getNodeID()] = fnNode->getNodeID();
     }
@@ -287,15 +312,17 @@ std::optional<std::pair<int, int>> pdg::MiniZincPrinter::calculateCollatedRange(
 }
 
 
-std::map<unsigned int, bool> pdg::MiniZincPrinter::fnResultUsed(pdg::EdgeRangesAndIds edges)
+std::vector<bool> pdg::MiniZincPrinter::fnResultUsed(pdg::EdgeRangesAndIds edges, size_t numNodeIds)
 {
-  std::map<unsigned int, bool> result;
+  // keyed by the callee's entry node, which is what exportOneway looks up
+  std::vector<bool> result(numNodeIds, false);
   for(auto edge : edges.ordered)
   {
     if(edge->getEdgeType() == EdgeType::CONTROLDEP_CALLINV)
     {
-      result[edge->getEdgeID()] = 
-        result[edge->getEdgeID()] || edge->getSrcNode()->getValue()->user_empty(); 
+      auto calleeId = edge->getDstNode()->getNodeID();
+      result[calleeId] = 
+        result[calleeId] || edge->getSrcNode()->getValue()->user_empty(); 
     }
   }
   return result;
@@ -410,14 +437,14 @@ void pdg::MiniZincPrinter::exportMznSrcDst(std::ofstream &mzn, pdg::NodeRangesAn
   exportVector(mzn, "hasDest", hasDstVec);
 }
 
-void pdg::MiniZincPrinter::exportMznHasFn(std::ofstream &mzn, pdg::NodeRangesAndIds nodes, std::map<unsigned int, unsigned int> hasFn)
+void pdg::MiniZincPrinter::exportMznHasFn(std::ofstream &mzn, pdg::NodeRangesAndIds nodes, std::vector<std::optional<unsigned int>> hasFn)
 {
 
   std::vector<size_t> hasFnVec; 
   for(auto node : nodes.ordered)
   {
-    if(hasFn.find(node->getNodeID()) != hasFn.end())
-      hasFnVec.push_back(nodes.ids[hasFn[node->getNodeID()]] + 1); 
+    if(auto fnId = hasFn[node->getNodeID()])
+      hasFnVec.push_back(nodes.ids[*fnId] + 1); 
     else
       hasFnVec.push_back(0);
   }
@@ -454,7 +481,7 @@ void pdg::MiniZincPrinter::exportMznUserAnnotated(std::ofstream &mzn, pdg::NodeR
   {
     if(node->getNodeType() == GraphNodeType::FUNC_ENTRY)
     {
-      if(node->getAnno() != "None") 
+      if(node->hasAnno()) 
         userAnnotated.push_back("true");
       else
         userAnnotated.push_back("false");
@@ -469,7 +496,7 @@ void pdg::MiniZincPrinter::exportMznConstraints(std::ofstream &mzn, pdg::NodeRan
   for(size_t i = 0; i < nodes.ordered.size(); i++)
   {
     auto node = nodes.ordered[i];
-    if(node->getAnno() != "None")
+    if(node->hasAnno())
     {
       mzn << "constraint :: \"TaintOnNodeIdx";
       mzn << i + 1;
@@ -479,7 +506,7 @@ void pdg::MiniZincPrinter::exportMznConstraints(std::ofstream &mzn, pdg::NodeRan
   }
 }
 
-void pdg::MiniZincPrinter::exportMzn(std::string filename, pdg::NodeRangesAndIds nodes, pdg::EdgeRangesAndIds edges, std::map<unsigned int, unsigned int> hasFn, size_t maxFuncParams)
+void pdg::MiniZincPrinter::exportMzn(std::string filename, pdg::NodeRangesAndIds nodes, pdg::EdgeRangesAndIds edges, std::vector<std::optional<unsigned int>> hasFn, size_t maxFuncParams)
 {
   std::ofstream mzn;
   mzn.open(filename);
@@ -496,7 +523,7 @@ void pdg::MiniZincPrinter::exportMzn(std::string filename, pdg::NodeRangesAndIds
 }
 
 
-void pdg::MiniZincPrinter::exportDebug(std::string filename, pdg::NodeRangesAndIds nodes, pdg::EdgeRangesAndIds edges, std::map<unsigned int, unsigned int> hasFn)
+void pdg::MiniZincPrinter::exportDebug(std::string filename, pdg::NodeRangesAndIds nodes, pdg::EdgeRangesAndIds edges, std::vector<std::optional<unsigned int>> hasFn)
 {
 
   std::ofstream debug;
@@ -516,12 +543,12 @@ void pdg::MiniZincPrinter::exportDebug(std::string filename, pdg::NodeRangesAndI
       valueStr = "No Value";
 
     std::string anno;
-    if((anno = node->getAnno()) == "None")
-      anno = "";
+    if(node->hasAnno())
+      anno = node->getAnno();
 
     size_t fn = 0; 
-    if(hasFn.find(node->getNodeID()) != hasFn.end())
-      fn = nodes.ids[hasFn[node->getNodeID()]] + 1;
+    if(auto fnId = hasFn[node->getNodeID()])
+      fn = nodes.ids[*fnId] + 1;
 
     debug 
       << "Node" << delim 
@@ -568,7 +595,7 @@ void pdg::MiniZincPrinter::exportFnArgs(std::string filename, pdg::NodeRangesAnd
   fnArgs.open(filename);
   for(auto node : nodes.ordered)
   {
-    if(node->getNodeType() == GraphNodeType::FUNC_ENTRY && node->getAnno() != "None")
+    if(node->getNodeType() == GraphNodeType::FUNC_ENTRY && node->hasAnno())
     {
       fnArgs << node->getFunc()->getName().str() << " ";
       fnArgs << node->getAnno() << " ";
@@ -580,13 +607,13 @@ void pdg::MiniZincPrinter::exportFnArgs(std::string filename, pdg::NodeRangesAnd
 }
 
 
-void pdg::MiniZincPrinter::exportOneway(std::string filename, pdg::NodeRangesAndIds nodes, std::map<unsigned int, bool> fnResultUsed)
+void pdg::MiniZincPrinter::exportOneway(std::string filename, pdg::NodeRangesAndIds nodes, std::vector<bool> fnResultUsed)
 {
   std::ofstream oneway;
   oneway.open(filename);
   for(auto node : nodes.ordered)
   {
-    if(node->getNodeType() == GraphNodeType::FUNC_ENTRY && node->getAnno() != "None")
+    if(node->getNodeType() == GraphNodeType::FUNC_ENTRY && node->hasAnno())
     {
       oneway << node->getFunc()->getName().str() << " ";
       oneway << node->getAnno() << " ";
@@ -614,7 +641,7 @@ void pdg::MiniZincPrinter::exportLineNumbers(std::string filename, pdg::NodeRang
   lineNumbers.close();
 }
 
-void pdg::MiniZincPrinter::exportNodeToLLID(std::string filename, pdg::NodeRangesAndIds nodes, std::map<unsigned int, unsigned int> hasFn)
+void pdg::MiniZincPrinter::exportNodeToLLID(std::string filename, pdg::NodeRangesAndIds nodes, std::vector<std::optional<unsigned int>> hasFn)
 {
   std::ofstream nodeToLLID;
   nodeToLLID.open(filename);
@@ -636,9 +663,9 @@ void pdg::MiniZincPrinter::exportNodeToLLID(std::string filename, pdg::NodeRange
     {
       nodeToLLID << glob->getName().str();  
     }
-    else if(hasFn.find(node->getNodeID()) != hasFn.end())
+    else if(auto fnId = hasFn[node->getNodeID()])
     {
-      auto fnNode = nodes.ordered[nodes.ids[hasFn[node->getNodeID()]]];
+      auto fnNode = nodes.ordered[nodes.ids[*fnId]];
       if(auto fn = fnNode->getFunc())
       {
         if(fn->hasName()) 
@@ -672,24 +699,43 @@ void pdg::MiniZincPrinter::exportNodeToLLID(std::string filename, pdg::NodeRange
 
 bool pdg::MiniZincPrinter::runOnModule(Module &M)
 {
-  auto PDG = &ProgramGraph::getInstance();
+  exportGraph(*getAnalysis<ProgramDependencyGraph>().getPDG());
+  return false;
+}
+
+void pdg::MiniZincPrinter::exportGraph(ProgramGraph &g, bool export_mzn, bool export_csv)
+{
+  auto PDG = &g;
   auto nodesByType = nodesByNodeType(*PDG);
-  auto edgesByType = edgesByEdgeType(*PDG);
+  std::deque<Edge> rangeEdges;
+  auto edgesByType = edgesByEdgeType(*PDG, rangeEdges);
   auto nodesByMzn = map_key_optional(std::function<std::optional<pdg::MznNodeType>(pdg::GraphNodeType)>(pdg::MiniZincPrinter::nodeMznType), nodesByType);   
   auto edgesByMzn = map_key_optional(std::function<std::optional<pdg::MznEdgeType>(pdg::EdgeType)>(pdg::MiniZincPrinter::edgeMznType), edgesByType);
 
-  auto nodesById = toRangesAndIds(nodesByMzn, std::function<unsigned int(Node *)>([](Node *n) { return n->getNodeID(); }));
-  auto edgesById = toRangesAndIds(edgesByMzn, std::function<unsigned int(Edge *)>([](Edge *n) { return n->getEdgeID(); }));
+  auto numNodeIds = PDG->getArena().numNodeIDs();
+  auto numEdgeIds = PDG->getArena().numEdgeIDs() + rangeEdges.size();
+  auto nodesById = toRangesAndIds(nodesByMzn, std::function<unsigned int(Node *)>([](Node *n) { return n->getNodeID(); }), numNodeIds);
+  auto edgesById = toRangesAndIds(edgesByMzn, std::function<unsigned int(Edge *)>([](Edge *n) { return n->getEdgeID(); }), numEdgeIds);
 
   auto functions = hasFn(*PDG); 
   auto maxParams = maxFnParams(*PDG);
-  auto fnResultUses = fnResultUsed(edgesById);
+  auto fnResultUses = fnResultUsed(edgesById, numNodeIds);
+
+  if (export_mzn)
+  {
+    exportMzn("pdg_instance.mzn", nodesById, edgesById, functions, maxParams);
+    errs() << "exported pdg_instance.mzn\n";
+  }
 
-  exportMzn("pdg_instance.mzn", nodesById, edgesById, functions, maxParams);
-  errs() << "exported pdg_instance.mzn\n";
+  if (export_csv)
+  {
+    exportDebug("pdg_data.csv", nodesById, edgesById, functions);
+    errs() << "exported pdg_data.csv\n";
+  }
 
-  exportDebug("pdg_data.csv", nodesById, edgesById, functions);
-  errs() << "exported pdg_data.csv\n";
+  // the side files belong to the minizinc instance
+  if (!export_mzn)
+    return;
 
   exportFnArgs("functionArgs.txt", nodesById);
   errs() << "exported functionArgs.txt\n";
@@ -702,8 +748,13 @@ bool pdg::MiniZincPrinter::runOnModule(Module &M)
 
   exportNodeToLLID("pdg_node_to_llid.csv", nodesById, functions);
   errs() << "exported pdg_node_to_llid.csv\n";
+}
 
-  return false;
+PreservedAnalyses pdg::MiniZincPrinterPass::run(Module &M, ModuleAnalysisManager &MAM)
+{
+  ProgramDependencyGraphPass().run(M, MAM);
+  MiniZincPrinter::exportGraph(*MAM.getResult<ProgramGraphAnalysis>(M).graph);
+  return PreservedAnalyses::all();
 }
 
 
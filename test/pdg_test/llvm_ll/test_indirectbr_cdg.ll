@@ -0,0 +1,16 @@
+; indirectbr: inc and dec depend on the indirectbr, 2 + 1 instructions, so 3 ControlDep_Br edges
+define i32 @dispatch(i8* %target, i32 %x) {
+entry:
+  indirectbr i8* %target, [label %inc, label %dec]
+
+inc:
+  %a = add i32 %x, 1
+  br label %exit
+
+dec:
+  br label %exit
+
+exit:
+  %r = phi i32 [ %a, %inc ], [ %x, %dec ]
+  ret i32 %r
+}
@@ -0,0 +1,23 @@
+; a 3-way switch: zero, one and other depend on the switch, 2 + 2 + 1 instructions, so 5 ControlDep_Br edges
+define i32 @classify(i32 %x) {
+entry:
+  switch i32 %x, label %other [
+    i32 0, label %zero
+    i32 1, label %one
+  ]
+
+zero:
+  %a = add i32 %x, 10
+  br label %exit
+
+one:
+  %b = mul i32 %x, 3
+  br label %exit
+
+other:
+  br label %exit
+
+exit:
+  %r = phi i32 [ %a, %zero ], [ %b, %one ], [ 0, %other ]
+  ret i32 %r
+}
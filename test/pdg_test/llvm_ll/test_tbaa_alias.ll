@@ -0,0 +1,15 @@
+; the float store cannot clobber the int load under TBAA, -pdg-alias=tbaa must give the same graph with and without worker threads
+define i32 @f(i32* %p, float* %q) {
+entry:
+  store i32 1, i32* %p, align 4, !tbaa !0
+  store float 2.0, float* %q, align 4, !tbaa !4
+  %v = load i32, i32* %p, align 4, !tbaa !0
+  ret i32 %v
+}
+
+!0 = !{!1, !1, i64 0}
+!1 = !{!"int", !2, i64 0}
+!2 = !{!"omnipotent char", !3, i64 0}
+!3 = !{!"Simple C/C++ TBAA"}
+!4 = !{!5, !5, i64 0}
+!5 = !{!"float", !2, i64 0}
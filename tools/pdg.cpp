@@ -0,0 +1,313 @@
+// pdg: builds the program dependence graph of one bitcode file and writes the requested
+// outputs, without going through opt. Takes the same -pdg-* options as the passes.
+#include "DataDependencyGraph.hh"
+#include "ProgramDependencyGraph.hh"
+#include "GraphWriter.hh"
+#include "zincPrinter.hh"
+#include "PDGUtils.hh"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/SourceMgr.h"
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+namespace
+{
+  enum class OutputKind
+  {
+    MZN,
+    CSV,
+    DOT,
+    STATS
+  };
+
+  cl::opt<std::string> InputFilename(cl::Positional, cl::desc("<input bitcode>"), cl::init("-"), cl::value_desc("filename"));
+
+  cl::list<OutputKind> Emit("emit", cl::desc("outputs to write, comma separated (default mzn,csv)"), cl::CommaSeparated,
+                            cl::values(clEnumValN(OutputKind::MZN, "mzn", "pdg_instance.mzn and the minizinc side files"),
+                                       clEnumValN(OutputKind::CSV, "csv", "pdg_data.csv"),
+                                       clEnumValN(OutputKind::DOT, "dot", "pdg-graph.dot"),
+                                       clEnumValN(OutputKind::STATS, "stats", "node and edge counts per type on stdout")));
+
+  cl::opt<bool> Lazy("lazy", cl::desc("only read the function bodies reachable from annotated functions and globals (llvm.global.annotations) and from -lazy-roots"), cl::init(false));
+
+  cl::list<std::string> LazyRoots("lazy-roots", cl::desc("extra functions whose bodies -lazy reads, e.g. the ones holding llvm.var.annotation calls"), cl::CommaSeparated, cl::value_desc("function names"));
+
+  cl::opt<bool> MaterializeControlDeps("materialize-control-deps", cl::desc("turn the per block control dependences into edge objects before the outputs are written, they must not change (test/pdg_test/check.sh)"), cl::Hidden, cl::init(false));
+
+  // wall clock time of each phase, printed at exit
+  class PhaseTimer
+  {
+  public:
+    PhaseTimer() : _start(std::chrono::steady_clock::now()), _last(_start) {}
+    void record(StringRef name)
+    {
+      auto now = std::chrono::steady_clock::now();
+      _phases.emplace_back(name.str(), std::chrono::duration<double, std::milli>(now - _last).count());
+      _last = now;
+    }
+    void print(raw_ostream &os) const
+    {
+      os << "pdg timing (ms):\n";
+      for (auto &phase : _phases)
+        os << "  " << left_justify(phase.first, 12) << format("%10.1f", phase.second) << "\n";
+      os << "  " << left_justify("total", 12) << format("%10.1f", std::chrono::duration<double, std::milli>(_last - _start).count()) << "\n";
+    }
+
+  private:
+    std::chrono::steady_clock::time_point _start;
+    std::chrono::steady_clock::time_point _last;
+    std::vector<std::pair<std::string, double>> _phases;
+  };
+
+  // functions referenced by a constant, looking through casts, geps and aggregates
+  void collectFunctions(const Constant *c, SmallPtrSetImpl<const Constant *> &visited, std::vector<Function *> &funcs)
+  {
+    if (!visited.insert(c).second)
+      return;
+    if (auto F = dyn_cast<Function>(c))
+    {
+      funcs.push_back(const_cast<Function *>(F));
+      return;
+    }
+    // a global's initializer is followed once the global itself is reached
+    if (auto gv = dyn_cast<GlobalVariable>(c))
+    {
+      if (gv->hasInitializer())
+        collectFunctions(gv->getInitializer(), visited, funcs);
+      return;
+    }
+    for (auto &op : c->operands())
+    {
+      if (auto op_c = dyn_cast<Constant>(op))
+        collectFunctions(op_c, visited, funcs);
+    }
+  }
+
+  // functions with a body that call one of the callees, looking only at the bodies already read
+  void collectCallers(ArrayRef<Function *> callees, std::vector<Function *> &funcs)
+  {
+    for (auto callee : callees)
+    {
+      for (auto user : callee->users())
+      {
+        if (auto cb = dyn_cast<CallBase>(user))
+          funcs.push_back(cb->getFunction());
+      }
+    }
+  }
+
+  // materialize the bodies reachable from the annotated functions and globals and turn every
+  // other function into a declaration without reading it. Returns the number of bodies read.
+  // A llvm.var.annotation is only seen if its function is reached or named by -lazy-roots. If the
+  // module declares it and none of the bodies read so far calls it, the other bodies are read
+  // to find its callers, which then become roots as well
+  unsigned materializeAnnotatedCode(Module &M)
+  {
+    ExitOnError exit_on_err("pdg: ");
+    std::vector<Function *> worklist;
+    SmallPtrSet<const Constant *, 32> visited;
+    if (auto annotations = M.getNamedGlobal("llvm.global.annotations"))
+    {
+      if (annotations->hasInitializer())
+        collectFunctions(annotations->getInitializer(), visited, worklist);
+    }
+    for (auto &name : LazyRoots)
+    {
+      if (auto F = M.getFunction(name))
+        worklist.push_back(F);
+      else
+        errs() << "pdg: -lazy-roots: no function named " << name << "\n";
+    }
+
+    SmallPtrSet<Function *, 32> reached;
+    auto materializeReachable = [&]() {
+      while (!worklist.empty())
+      {
+        Function *F = worklist.back();
+        worklist.pop_back();
+        if (!reached.insert(F).second)
+          continue;
+        exit_on_err(F->materialize());
+        for (auto &inst : instructions(F))
+        {
+          for (auto &op : inst.operands())
+          {
+            if (auto c = dyn_cast<Constant>(op))
+              collectFunctions(c, visited, worklist);
+          }
+        }
+      }
+    };
+    materializeReachable();
+
+    SmallVector<Function *, 2> var_annotations;
+    for (auto &F : M)
+    {
+      if (F.getIntrinsicID() == Intrinsic::var_annotation)
+        var_annotations.push_back(&F);
+    }
+    if (!var_annotations.empty())
+    {
+      std::vector<Function *> callers;
+      collectCallers(var_annotations, callers);
+      if (callers.empty())
+      {
+        errs() << "pdg: -lazy: the module declares llvm.var.annotation but no root calls it, reading the other function bodies to find its callers (name them with -lazy-roots to skip this)\n";
+        for (auto &F : M)
+        {
+          if (!reached.count(&F))
+            exit_on_err(F.materialize());
+        }
+        collectCallers(var_annotations, worklist);
+        materializeReachable();
+      }
+    }
+
+    unsigned num_read = 0;
+    for (auto &F : M)
+    {
+      if (reached.count(&F))
+        num_read += !F.isDeclaration();
+      else if (!F.isDeclaration())
+        F.deleteBody();
+    }
+    exit_on_err(M.materializeMetadata());
+    return num_read;
+  }
+
+  void printStats(Module &M, pdg::ProgramGraph &g, raw_ostream &os)
+  {
+    unsigned num_funcs = 0;
+    for (auto &F : M)
+    {
+      if (!F.isDeclaration() && g.hasFuncWrapper(F))
+        num_funcs++;
+    }
+    auto &frozen = g.getFrozenGraph();
+    std::map<pdg::GraphNodeType, unsigned> node_counts;
+    std::map<pdg::EdgeType, unsigned> edge_counts;
+    for (unsigned i = 0; i < frozen.size(); i++)
+    {
+      node_counts[frozen.getNode(i)->getNodeType()]++;
+      for (auto &out_edge : frozen.getOutEdges(i))
+        edge_counts[out_edge.edge_type]++;
+      for (auto &range : frozen.getOutRangeEdges(i))
+        edge_counts[range.edge_type] += range.count;
+    }
+    os << "functions: " << num_funcs << "\n";
+    os << "nodes: " << frozen.size() << "\n";
+    for (auto &pair : node_counts)
+      os << "  " << pdg::pdgutils::getNodeTypeStr(pair.first) << ": " << pair.second << "\n";
+    os << "edges: " << frozen.numEdges() << "\n";
+    for (auto &pair : edge_counts)
+      os << "  " << pdg::pdgutils::getEdgeTypeStr(pair.first) << ": " << pair.second << "\n";
+  }
+} // namespace
+
+int main(int argc, char **argv)
+{
+  InitLLVM X(argc, argv);
+  cl::ParseCommandLineOptions(argc, argv, "program dependence graph builder\n");
+  bool emit_mzn = Emit.empty(), emit_csv = Emit.empty(), emit_dot = false, emit_stats = false;
+  for (auto kind : Emit)
+  {
+    emit_mzn |= kind == OutputKind::MZN;
+    emit_csv |= kind == OutputKind::CSV;
+    emit_dot |= kind == OutputKind::DOT;
+    emit_stats |= kind == OutputKind::STATS;
+  }
+
+  PhaseTimer timer;
+  LLVMContext ctx;
+  SMDiagnostic err;
+  std::unique_ptr<Module> M = Lazy ? getLazyIRFileModule(InputFilename, err, ctx) : parseIRFile(InputFilename, err, ctx);
+  if (!M)
+  {
+    err.print(argv[0], errs());
+    return 1;
+  }
+  timer.record("parse");
+  if (Lazy)
+  {
+    unsigned num_funcs = 0;
+    for (auto &F : *M)
+      num_funcs += F.isMaterializable();
+    unsigned num_read = materializeAnnotatedCode(*M);
+    errs() << "pdg: read " << num_read << " of " << num_funcs << " function bodies\n";
+    timer.record("materialize");
+  }
+
+  // only the function analyses the graph passes ask for are ever computed
+  LoopAnalysisManager LAM;
+  FunctionAnalysisManager FAM;
+  CGSCCAnalysisManager CGAM;
+  ModuleAnalysisManager MAM;
+  PassBuilder PB;
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  pdg::ProgramGraph g;
+  pdg::MemoryReport mem_report;
+  g.build(*M);
+  g.bindDITypeToNodes(*M);
+  if (pdg::MEMREPORT)
+    mem_report.recordPhase("build", g);
+  timer.record("build");
+
+  pdg::DataDependencyGraph ddg;
+  auto analyses = pdg::DataDependencyAnalyses::fromFunctionAnalysisManager(FAM);
+  ddg.buildDataDependencies(*M, g, mem_report, analyses);
+  timer.record("ddg");
+
+  pdg::ProgramDependencyGraph pdg_builder;
+  pdg_builder.buildPDG(*M, g, mem_report, [&FAM](Function &F) -> PostDominatorTree & { return FAM.getResult<PostDominatorTreeAnalysis>(F); });
+  timer.record("pdg");
+  if (Lazy && g.getNodeSet().empty())
+    errs() << "pdg: -lazy: no annotated function, global or -lazy-roots function was found, the graph is empty\n";
+  if (MaterializeControlDeps)
+  {
+    g.materializeLazyEdges();
+    g.freeze();
+  }
+
+  if (emit_mzn || emit_csv)
+  {
+    pdg::MiniZincPrinter::exportGraph(g, emit_mzn, emit_csv);
+    timer.record("mzn/csv");
+  }
+
+  if (emit_dot)
+  {
+    std::error_code ec;
+    raw_fd_ostream dot_file("pdg-graph.dot", ec, sys::fs::OF_TextWithCRLF);
+    if (ec)
+      errs() << "cannot open pdg-graph.dot: " << ec.message() << "\n";
+    else
+    {
+      WriteGraph(dot_file, &pdg_builder, false, "Program Dependency Graph");
+      errs() << "exported pdg-graph.dot\n";
+    }
+    timer.record("dot");
+  }
+
+  if (emit_stats)
+  {
+    printStats(*M, g, outs());
+    timer.record("stats");
+  }
+
+  timer.print(errs());
+  return 0;
+}